@@ -1,129 +1,69 @@
-﻿#include "CamelliaSBOX.h"
+﻿#include "Camellia.h"
+#include "CamelliaSBOX.h"
 #include <iostream>
+#include <cstring>
+#include <stdexcept>
 using namespace std;
 
-#define TEST_VECTOR 0
-#define BLOCK_128_BIT 16
-#define KEY_128_BIT 16
-#define KEY_192_BIT 24
-#define KEY_256_BIT 32
 
-int KEY_MODE;
-
-typedef unsigned long long u64;
-typedef unsigned int u32;
-typedef unsigned char* u8;
-typedef u32 u128[5];
-typedef u32 u192[7];
-typedef u32 u256[9];
-
-#define ROTL32(x, n) ((x) << (n)) | ((x) >> (32 - (n)))
-#define ROTL64(x, n) (x << n) | (x >> (64 - n))
-#define MaskLeft(x) ((u64)x[0] << 32) | x[1]
-#define MaskRight(x) ((u64)x[2] << 32) | x[3]
-#define ByteToBit(x) (u64)(((u64)x[0] << 56) | ((u64)x[1] << 48) | ((u64)x[2] << 40) | ((u64)x[3] << 32) | ((u64)x[4] << 24) | ((u64)x[5] << 16)| ((u64)x[6] << 8) | ((u64)x[7] << 0))
-
-void ROTL128(u128& x, int n) {
-
-    u32 t = x[0] >> (32 - n);
-    x[0] = (x[0] << n) | (x[1] >> (32 - n));
-    x[1] = (x[1] << n) | (x[2] >> (32 - n));
-    x[2] = (x[2] << n) | (x[3] >> (32 - n));
-    x[3] = (x[3] << n) | t;
+// 128-бітне x = (x[0], x[1]), обернене ліворуч на N, відоме під час компіляції:
+// кожен підключ береться прямо з KL/KR/KA/KB без ланцюжка послідовних зсувів
+template <int N>
+static inline void Rotl128(const u64* x, u64& left, u64& right) {
+    const u64 hi = N >= 64 ? x[1] : x[0], lo = N >= 64 ? x[0] : x[1];
+    const int n = N % 64;
+    left = n ? (hi << n) | (lo >> ((64 - n) & 63)) : hi;
+    right = n ? (lo << n) | (hi >> ((64 - n) & 63)) : lo;
 }
-void U8strncpy(u8 to, u8 from, int howMany) {
-    for (size_t i = 0; i < howMany; i++)
-        to[i] = from[i];
-    to[howMany] = '\0';
+void ConsoleHexOutput(const unsigned char* data, size_t length, const char* stringName) {
+    cout << stringName;
+    for (size_t i = 0; i < length; i++)
+        cout << hex << (int)data[i] << " ";
+    cout << endl;
 }
 void ConsoleHexOutput(u8 string, const char* stringName) {
-    cout << stringName;
-    int length = strlen((char*)string);
+    size_t length = strlen((char*)string);
 #if TEST_VECTOR
     length = 16;
 #endif
-    for (size_t i = 0; i < length; i++)
-        cout << hex << (int)string[i] << " ";
-    cout << endl;
+    ConsoleHexOutput(string, length, stringName);
 }
-u8 BitToByte(u64 left, u64 right)
-{
-    u8 result = new unsigned char[17];
-    int i = 0;
-    for (; i < 8; i++)
-        result[i] = (unsigned char)(left >> ((7 - i) << 3) & 0xff);
-    for (; i < 16; i++)
-        result[i] = (unsigned char)(right >> ((15 - i) << 3) & 0xff);
+// Байт SBOX1[x]; у режимі сталого часу - проходом усієї таблиці з маскою,
+// без звернення за секретним індексом
+static inline u32 SBox1(u64 x) {
+    const unsigned char* s1 = CAMELLIA_TABLES.sbox[0];
+#if CAMELLIA_CONSTANT_TIME
+    u32 result = 0;
+    for (u32 i = 0; i < 256; i++)
+        result |= s1[i] & (0u - (((i ^ (u32)x) - 1) >> 31));
     return result;
+#else
+    return s1[x];
+#endif
 }
-class Camellia {
-private:
-
-    u64 kw[4] = {}, ke[6] = {}, k[24] = {};
-    u128 KA = {}, KL = {}, KR = {}, KB = {};
-    u128 key128 = {};
-    u192 key192 = {};
-    u256 key256 = {};
-
-#define MASK8	0xff
-#define MASK32	0xffffffff
-#define MASK64	0xffffffffffffffff
-#define MASK128	0xffffffffffffffffffffffffffffffff
-#define C1	0xA09E667F3BCC908B
-#define C2	0xB67AE8584CAA73B2
-#define C3	0xC6EF372FE94F82BE
-#define C4	0x54FF53A5F1D36F1C
-#define C5	0x10E527FADE682D1D
-#define C6	0xB05688C2B3E6C1FD
-    void KeyGen128();
-    void KeyGen192_256();
-    void FormKA();
-    void FormKB();
-    void KeyInit(u8 key, int length);
-    u64 F_Func(u64 F_IN, u64 KE);
-    u64 FL_Func(u64 FL_IN, u64 KE);
-    u64 FLINV_Func(u64 FLINV_IN, u64 KE);
-    u8 OneBlockCamelliaEncrypt(u64 left, u64 right);
-    u8 OneBlockCamelliaDecrypt(u64 left, u64 right);
-    u8 Camellia_ECB(int length, u8 text);
-public:
-    u8 CamelliaEncrypt(u8 text, u8 key);
-    u8 CamelliaDecrypt(u8 cipherText, u8 key);
-};
 u64 Camellia::F_Func(u64 F_IN, u64 KE) {
     u64 x = F_IN ^ KE;
 
-    u32 t[8], y[8];
-    int shiftBit = 56;
-    t[0] = x >> shiftBit;
-    for (size_t i = 1; i < 8; i++)
-    {
-        shiftBit -= 8;
-        t[i] = (x >> shiftBit) & MASK8;
-    }
-
-    t[0] = SBOX[0][t[0]];
-    t[1] = SBOX[1][t[1]];
-    t[2] = SBOX[2][t[2]];
-    t[3] = SBOX[3][t[3]];
-    t[4] = SBOX[1][t[4]];
-    t[5] = SBOX[2][t[5]];
-    t[6] = SBOX[3][t[6]];
-    t[7] = SBOX[0][t[7]];
-
-    u32 temp = t[0] ^ t[1] ^ t[2] ^ t[3] ^ t[4] ^ t[5] ^ t[6] ^ t[7];
-    y[0] = temp ^ t[1] ^ t[4];
-    y[1] = temp ^ t[2] ^ t[5];
-    y[2] = temp ^ t[3] ^ t[6];
-    y[3] = temp ^ t[0] ^ t[7];
-    y[4] = temp ^ t[2] ^ t[3] ^ t[4];
-    y[5] = temp ^ t[0] ^ t[3] ^ t[5];
-    y[6] = temp ^ t[0] ^ t[1] ^ t[6];
-    y[7] = temp ^ t[1] ^ t[2] ^ t[7];
+#if CAMELLIA_COMPACT_SBOX || CAMELLIA_CONSTANT_TIME
+    // Лише 256-байтний SBOX1: решта S-блоків - його циклічні зсуви,
+    // а множення на константу розкладає байт по позиціях P-функції
+    u32 a = SBox1(x >> 56) * 0x01010100u ^ ROTL8(SBox1((x >> 48) & MASK8), 1) * 0x00010101u ^
+        ROTL8(SBox1((x >> 40) & MASK8), 7) * 0x01000101u ^ SBox1(ROTL8((x >> 32) & MASK8, 1)) * 0x01010001u;
+    u32 b = ROTL8(SBox1((x >> 24) & MASK8), 1) * 0x00010101u ^ ROTL8(SBox1((x >> 16) & MASK8), 7) * 0x01000101u ^
+        SBox1(ROTL8((x >> 8) & MASK8, 1)) * 0x01010001u ^ SBox1(x & MASK8) * 0x01010100u;
+#else
+    // SP-таблиці поєднують S-блок і P-функцію: ліва половина виходу
+    // дорівнює A ^ B, права - (A ^ B) ^ (A >>> 8)
+    const CamelliaTables& t = CAMELLIA_TABLES;
+    u32 a = t.sp1110[x >> 56] ^ t.sp0222[(x >> 48) & MASK8] ^
+        t.sp3033[(x >> 40) & MASK8] ^ t.sp4404[(x >> 32) & MASK8];
+    u32 b = t.sp0222[(x >> 24) & MASK8] ^ t.sp3033[(x >> 16) & MASK8] ^
+        t.sp4404[(x >> 8) & MASK8] ^ t.sp1110[x & MASK8];
+#endif
+    u32 left = a ^ b;
+    u32 right = left ^ ROTR32(a, 8);
 
-    return ((u64)y[0] << 56) | ((u64)y[1] << 48) | ((u64)y[2] << 40) |
-        ((u64)y[3] << 32) | ((u64)y[4] << 24) | ((u64)y[5] << 16) |
-        ((u64)y[6] << 8) | (u64)y[7];
+    return ((u64)left << 32) | right;
 }
 u64 Camellia::FL_Func(u64 FL_IN, u64 KE) {
     u32 x1, x2, k1, k2;
@@ -148,330 +88,377 @@ u64 Camellia::FLINV_Func(u64 FLINV_IN, u64 KE) {
     y2 = y2 ^ ROTL32(y1 & k1, 1);
     return ((u64)y1 << 32) | y2;
 }
-void Camellia::FormKA() {
-    u64 L = MaskLeft(KL),
-        R = MaskRight(KL);
-    R = R ^ F_Func(L, C1);
-    L = L ^ F_Func(R, C2);
+void CamelliaKey::FormKA(const u128& KL, const u128& KR, u128& KA) {
+    u64 L = MaskLeft(KL) ^ MaskLeft(KR),
+        R = MaskRight(KL) ^ MaskRight(KR);
+    R = R ^ Camellia::F_Func(L, C1);
+    L = L ^ Camellia::F_Func(R, C2);
     L = L ^ MaskLeft(KL);
     R = R ^ MaskRight(KL);
-    R = R ^ F_Func(L, C3);
-    L = L ^ F_Func(R, C4);
+    R = R ^ Camellia::F_Func(L, C3);
+    L = L ^ Camellia::F_Func(R, C4);
     KA[0] = L >> 32;
     KA[1] = L & 0xffffffff;
     KA[2] = R >> 32;
     KA[3] = R & 0xffffffff;
 }
-void Camellia::FormKB() {
-    u64 L = ((u64(KA[0] ^ KR[0]) << 32) | (KA[1] ^ KA[1])),
-        R = ((u64(KA[3] ^ KR[3]) << 32) | (KA[4] ^ KA[4]));
-    R = R ^ F_Func(L, C5);
-    L = L ^ F_Func(R, C6);
+void CamelliaKey::FormKB(const u128& KA, const u128& KR, u128& KB) {
+    u64 L = MaskLeft(KA) ^ MaskLeft(KR),
+        R = MaskRight(KA) ^ MaskRight(KR);
+    R = R ^ Camellia::F_Func(L, C5);
+    L = L ^ Camellia::F_Func(R, C6);
     KB[0] = L >> 32;
     KB[1] = L & 0xffffffff;
     KB[2] = R >> 32;
     KB[3] = R & 0xffffffff;
 }
-void Camellia::KeyGen128() {
-
-    FormKA();
-    //0
-    k[0] = MaskLeft(KA);
-    k[1] = MaskRight(KA);
-    ROTL128(KA, 15);//15
-    k[4] = MaskLeft(KA);
-    k[5] = MaskRight(KA);
-    ROTL128(KA, 15);//30
-    ke[0] = MaskLeft(KA);
-    ke[1] = MaskRight(KA);
-    ROTL128(KA, 15);//45
-    k[8] = MaskLeft(KA);
-    ROTL128(KA, 15);//60
-    k[10] = MaskLeft(KA);
-    k[11] = MaskRight(KA);
-    ROTL128(KA, 17);//77
-    ROTL128(KA, 17);//94
-    k[14] = MaskLeft(KA);
-    k[15] = MaskRight(KA);
-    ROTL128(KA, 17);//111
-    kw[2] = MaskLeft(KA);
-    kw[3] = MaskRight(KA);
-    //0
-    u128 tempKL = { KL[0], KL[1], KL[2], KL[3] };
-    kw[0] = MaskLeft(tempKL);
-    kw[1] = MaskRight(tempKL);
-    ROTL128(tempKL, 15);//15
-    k[2] = MaskLeft(tempKL);
-    k[3] = MaskRight(tempKL);
-    ROTL128(tempKL, 30);//45
-    k[6] = MaskLeft(tempKL);
-    k[7] = MaskRight(tempKL);
-    ROTL128(tempKL, 15);//60
-    k[9] = MaskRight(tempKL);
-    ROTL128(tempKL, 17);//77
-    ke[2] = MaskLeft(tempKL);
-    ke[3] = MaskRight(tempKL);
-    ROTL128(tempKL, 17);//94
-    k[12] = MaskLeft(tempKL);
-    k[13] = MaskRight(tempKL);
-    ROTL128(tempKL, 17);//111
-    k[16] = MaskLeft(tempKL);
-    k[17] = MaskRight(tempKL);
-}
-void Camellia::KeyGen192_256() {
-
-    FormKA();
-    FormKB();
-
-    k[0] = MaskLeft(KB);
-    k[1] = MaskRight(KB);
-    ROTL128(KB, 30);
-    k[6] = MaskLeft(KB);
-    k[7] = MaskRight(KB);
-    ROTL128(KB, 30);
-    k[14] = MaskLeft(KB);
-    k[15] = MaskRight(KB);
-    ROTL128(KB, 25);
-    ROTL128(KB, 26);
-    kw[2] = MaskLeft(KB);
-    kw[3] = MaskRight(KB);
-
-    
-    ROTL128(KR, 15);
-    k[2] = MaskLeft(KR);
-    k[3] = MaskRight(KR);
-    ROTL128(KR, 15);
-    ke[0] = MaskLeft(KR);
-    ke[1] = MaskRight(KR);
-    ROTL128(KR, 30);
-    k[12] = MaskLeft(KR);
-    k[13] = MaskRight(KR);
-    ROTL128(KR, 17);
-    ROTL128(KR, 17);
-    k[18] = MaskLeft(KR);
-    k[19] = MaskRight(KR);
-
-    kw[0] = MaskLeft(KL);
-    kw[1] = MaskRight(KL);
-    ROTL128(KL, 30);
-    ROTL128(KL, 15);
-    k[8] = MaskLeft(KL);
-    k[9] = MaskRight(KL);
-    ROTL128(KL, 15);
-    ke[2] = MaskLeft(KL);
-    ke[3] = MaskRight(KL);
-    ROTL128(KL, 17);
-    k[16] = MaskLeft(KL);
-    k[17] = MaskRight(KL);
-    ROTL128(KL, 17);
-    ROTL128(KL, 17);
-    k[22] = MaskLeft(KL);
-    k[23] = MaskRight(KL);
-
-    ROTL128(KA, 15);
-    k[4] = MaskLeft(KA);
-    k[5] = MaskRight(KA);
-    ROTL128(KA, 30);
-    k[10] = MaskLeft(KA);
-    k[11] = MaskRight(KA);
-    ROTL128(KA, 16);
-    ROTL128(KA, 16);
-    ke[4] = MaskLeft(KA);
-    ke[5] = MaskRight(KA);
-    ROTL128(KA, 17);
-    k[20] = MaskLeft(KA);
-    k[21] = MaskRight(KA);
-}
-u8 Camellia::OneBlockCamelliaEncrypt(u64 L, u64 R) {
-
-    L ^= kw[0]; // Попереднє забілювання
-    R ^= kw[1];
-    int j = 0;
-    for (size_t i = 0; i < 3; i++)
-    {
-        R ^= F_Func(L, k[j++]);
-        L ^= F_Func(R, k[j++]);
+void CamelliaKey::KeyGen128(const u64* KL, const u64* KA) {
+    u64 unused;
+    Rotl128<0>(KL, kw[0], kw[1]);
+    Rotl128<0>(KA, k[0], k[1]);
+    Rotl128<15>(KL, k[2], k[3]);
+    Rotl128<15>(KA, k[4], k[5]);
+    Rotl128<30>(KA, ke[0], ke[1]);
+    Rotl128<45>(KL, k[6], k[7]);
+    Rotl128<45>(KA, k[8], unused);
+    Rotl128<60>(KL, unused, k[9]);
+    Rotl128<60>(KA, k[10], k[11]);
+    Rotl128<77>(KL, ke[2], ke[3]);
+    Rotl128<94>(KL, k[12], k[13]);
+    Rotl128<94>(KA, k[14], k[15]);
+    Rotl128<111>(KL, k[16], k[17]);
+    Rotl128<111>(KA, kw[2], kw[3]);
+}
+void CamelliaKey::KeyGen192_256(const u64* KL, const u64* KR, const u64* KA, const u64* KB) {
+    Rotl128<0>(KL, kw[0], kw[1]);
+    Rotl128<0>(KB, k[0], k[1]);
+    Rotl128<15>(KR, k[2], k[3]);
+    Rotl128<15>(KA, k[4], k[5]);
+    Rotl128<30>(KR, ke[0], ke[1]);
+    Rotl128<30>(KB, k[6], k[7]);
+    Rotl128<45>(KL, k[8], k[9]);
+    Rotl128<45>(KA, k[10], k[11]);
+    Rotl128<60>(KL, ke[2], ke[3]);
+    Rotl128<60>(KR, k[12], k[13]);
+    Rotl128<60>(KB, k[14], k[15]);
+    Rotl128<77>(KL, k[16], k[17]);
+    Rotl128<77>(KA, ke[4], ke[5]);
+    Rotl128<94>(KR, k[18], k[19]);
+    Rotl128<94>(KA, k[20], k[21]);
+    Rotl128<111>(KL, k[22], k[23]);
+    Rotl128<111>(KB, kw[2], kw[3]);
+}
+// Шість раундів Фейстеля з індексами підключів, відомими під час компіляції;
+// N незалежних блоків іде раунд за раундом, щоб їхні звернення до таблиць перекривались
+template <int J, int N>
+inline void Camellia::SixRounds(const u64* k, u64* L, u64* R) {
+    for (int r = 0; r < 6; r += 2) {
+        for (int b = 0; b < N; b++)
+            R[b] ^= F_Func(L[b], k[J + r]);
+        for (int b = 0; b < N; b++)
+            L[b] ^= F_Func(R[b], k[J + r + 1]);
     }
-
-    L = FL_Func(L, ke[0]); // FL
-    R = FLINV_Func(R, ke[1]); // FLINV
-
-    for (size_t i = 0; i < 3; i++)
-    {
-        R ^= F_Func(L, k[j++]);
-        L ^= F_Func(R, k[j++]);
+}
+template <int N>
+inline void Camellia::FLLayer(u64* L, u64* R, u64 keL, u64 keR) {
+    for (int b = 0; b < N; b++) {
+        L[b] = FL_Func(L[b], keL); // FL
+        R[b] = FLINV_Func(R[b], keR); // FLINV
     }
-    L = FL_Func(L, ke[2]); // FL
-    R = FLINV_Func(R, ke[3]); // FLINV
-
-    for (size_t i = 0; i < 3; i++)
-    {
-        R ^= F_Func(L, k[j++]);
-        L ^= F_Func(R, k[j++]);
+}
+template <int N>
+inline void Camellia::Whitening(u64* L, u64* R, u64 kwL, u64 kwR) {
+    for (int b = 0; b < N; b++) {
+        L[b] ^= kwL;
+        R[b] ^= kwR;
     }
-    
-    if (KEY_MODE == 192 || KEY_MODE == 256) {
-        L = FL_Func(L, ke[4]); // FL
-        R = FLINV_Func(R, ke[5]); // FLINV
-        for (size_t i = 0; i < 3; i++)
-        {
-            R ^= F_Func(L, k[j++]);
-            L ^= F_Func(R, k[j++]);
-        }
+}
+// Спільне ядро для обох напрямків: розшифрування отримує розклад dkw/dke/dk.
+// ROUNDS = 18 для 128-бітного ключа, 24 - для 192/256-бітного
+template <int ROUNDS, int N>
+void Camellia::CryptCore(const u64* kw, const u64* ke, const u64* k, u64* blockL, u64* blockR) {
+    // Локальні копії: компілятор знає, що запис у них не змінює підключі
+    u64 L[N], R[N];
+    for (int b = 0; b < N; b++) {
+        L[b] = blockL[b];
+        R[b] = blockR[b];
     }
-    
-    R ^= kw[2];
-    L ^= kw[3];
-    return BitToByte(R, L);
-}
-u8 Camellia::Camellia_ECB(int length, u8 text) {
-    u8 encryptedText = new unsigned char[length + 1];
-    int shift = 0;
-    u8 left = new unsigned char[9],
-        right = new unsigned char[9];
-
-    bool isOneMoreBlock = length % BLOCK_128_BIT != 0;
-    int blocksAmount = (length / BLOCK_128_BIT);
-
-    for (size_t i = 0; i < blocksAmount; i++)
-    {
-        U8strncpy(left, text + shift, 8);
-        shift += 8;
-        U8strncpy(right, text + shift, 8);
-        shift += 8;
-        U8strncpy(encryptedText + shift - BLOCK_128_BIT, 
-            OneBlockCamelliaEncrypt(ByteToBit(left), ByteToBit(right)), BLOCK_128_BIT);
+    Whitening<N>(L, R, kw[0], kw[1]); // Попереднє забілювання
+    SixRounds<0, N>(k, L, R);
+    FLLayer<N>(L, R, ke[0], ke[1]);
+    SixRounds<6, N>(k, L, R);
+    FLLayer<N>(L, R, ke[2], ke[3]);
+    SixRounds<12, N>(k, L, R);
+    if (ROUNDS == 24) {
+        FLLayer<N>(L, R, ke[4], ke[5]);
+        SixRounds<18, N>(k, L, R);
     }
-    if (isOneMoreBlock) {
-        int lastBlockLength = length - BLOCK_128_BIT * blocksAmount;
-        u64 leftU64 = 0, rightU64 = 0;
-        if (lastBlockLength > 8) {
-            U8strncpy(left, text + shift, 8);
-            shift += 8;
-            U8strncpy(right, text + shift, lastBlockLength - 8);
-            shift += lastBlockLength - 8;
-            rightU64 = ByteToBit(right);
-            leftU64 = ByteToBit(left);
-        }
-        else {
-            U8strncpy(left, text + shift, lastBlockLength);
-            shift += lastBlockLength;
-            rightU64 = 0;
-            leftU64 = ByteToBit(left);
-            leftU64 = leftU64 & (0xFFFFffffFFFFffff << (64 - lastBlockLength*8));
+    Whitening<N>(R, L, kw[2], kw[3]); // Фінальне забілювання
+    for (int b = 0; b < N; b++) {
+        blockL[b] = L[b];
+        blockR[b] = R[b];
+    }
+}
+// Розклад для розшифрування в прямому порядку: kw[0..1] <-> kw[2..3],
+// пари FL/FLINV та раундові ключі - у зворотному порядку
+void CamelliaKey::FormDecryptionKeys() {
+    int keCount = (rounds / 6 - 1) * 2;
+    for (int i = 0; i < 4; i++)
+        dkw[i] = kw[i ^ 2];
+    for (int i = 0; i < 6; i++)
+        dke[i] = i < keCount ? ke[keCount - 1 - i] : 0;
+    for (int i = 0; i < 24; i++)
+        dk[i] = i < rounds ? k[rounds - 1 - i] : 0;
+}
+// Скалярне шифрування по N блоків одночасно для залишку після SIMD-бекенду
+template <int N>
+size_t Camellia::CryptInterleaved(const CamelliaKey& key, const unsigned char* in, unsigned char* out,
+    size_t blocks, bool decrypt) const
+{
+    void (*core)(const u64*, const u64*, const u64*, u64*, u64*) =
+        key.rounds == 24 ? &Camellia::CryptCore<24, N> : &Camellia::CryptCore<18, N>;
+    size_t i = 0;
+    for (; i + N <= blocks; i += N) {
+        u64 L[N], R[N];
+        for (int b = 0; b < N; b++) {
+            const unsigned char* block = in + (i + b) * BLOCK_128_BIT;
+            L[b] = ByteToBit(block);
+            R[b] = ByteToBit((block + 8));
         }
-        U8strncpy(encryptedText + shift - lastBlockLength,
-            OneBlockCamelliaDecrypt(leftU64,rightU64), lastBlockLength);
+        if (decrypt)
+            core(key.dkw, key.dke, key.dk, L, R);
+        else
+            core(key.kw, key.ke, key.k, L, R);
+        for (int b = 0; b < N; b++)
+            for (int j = 0; j < 8; j++) {
+                out[(i + b) * BLOCK_128_BIT + j] = (unsigned char)(R[b] >> ((7 - j) << 3));
+                out[(i + b) * BLOCK_128_BIT + 8 + j] = (unsigned char)(L[b] >> ((7 - j) << 3));
+            }
     }
-
-    encryptedText[length] = '\0';
-    delete[] left, right;
-    return encryptedText;
+    return i;
 }
-void Camellia::KeyInit(u8 key, int length)
+size_t Camellia::CryptBatches(const CamelliaKey& key, const unsigned char* in, unsigned char* out,
+    size_t blocks, bool decrypt) const
 {
+    size_t i = decrypt
+        ? CamelliaSelectedBackend().crypt(key.dkw, key.dke, key.dk, key.rounds, in, out, blocks)
+        : CamelliaSelectedBackend().crypt(key.kw, key.ke, key.k, key.rounds, in, out, blocks);
+    i += CryptInterleaved<4>(key, in + i * BLOCK_128_BIT, out + i * BLOCK_128_BIT, blocks - i, decrypt);
+    i += CryptInterleaved<2>(key, in + i * BLOCK_128_BIT, out + i * BLOCK_128_BIT, blocks - i, decrypt);
+    i += CryptInterleaved<1>(key, in + i * BLOCK_128_BIT, out + i * BLOCK_128_BIT, blocks - i, decrypt);
+    return i;
+}
+void Camellia::EncryptBlocks(const CamelliaKey& key, const unsigned char* in, unsigned char* out, size_t blocks) const {
+    CryptBatches(key, in, out, blocks, false);
+}
+void Camellia::DecryptBlocks(const CamelliaKey& key, const unsigned char* in, unsigned char* out, size_t blocks) const {
+    CryptBatches(key, in, out, blocks, true);
+}
+// Неповний блок ECB не можна зашифрувати оборотно без зміни довжини, тож
+// такий текст відкидається; для довільних довжин є CBC з PKCS#7 та CTR
+u8 Camellia::Camellia_ECB(const CamelliaKey& key, const unsigned char* text, size_t length, bool decrypt) const {
+    if (length % BLOCK_128_BIT)
+        return nullptr;
+    u8 result = new unsigned char[length + 1];
+    CryptBatches(key, text, result, length / BLOCK_128_BIT, decrypt);
+    result[length] = '\0';
+    return result;
+}
+bool Camellia::CamelliaEncryptInPlace(unsigned char* data, size_t length, const CamelliaKey& key) const {
+    if (length % BLOCK_128_BIT)
+        return false;
+    CryptBatches(key, data, data, length / BLOCK_128_BIT, false);
+    return true;
+}
+bool Camellia::CamelliaDecryptInPlace(unsigned char* data, size_t length, const CamelliaKey& key) const {
+    if (length % BLOCK_128_BIT)
+        return false;
+    CryptBatches(key, data, data, length / BLOCK_128_BIT, true);
+    return true;
+}
+bool Camellia::CryptBatch(const CamelliaRecord* records, size_t count, const CamelliaKey& key,
+    std::pmr::memory_resource* resource, CamelliaRecord* results, bool decrypt) const
+{
+    // Записи перевіряються до виділення: пакет або обробляється повністю, або ні
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (records[i].length % BLOCK_128_BIT)
+            return false;
+        total += records[i].length;
+    }
+    if (total == 0)
+        total = BLOCK_128_BIT;
+    unsigned char* out = (unsigned char*)resource->allocate(total, BLOCK_128_BIT);
+
+    for (size_t i = 0; i < count; i++) {
+        CryptBatches(key, records[i].data, out, records[i].length / BLOCK_128_BIT, decrypt);
+        results[i].data = out;
+        results[i].length = records[i].length;
+        out += records[i].length;
+    }
+    return true;
+}
+bool Camellia::CamelliaEncryptBatch(const CamelliaRecord* records, size_t count, const CamelliaKey& key,
+    std::pmr::memory_resource* resource, CamelliaRecord* results) const
+{
+    return CryptBatch(records, count, key, resource, results, false);
+}
+bool Camellia::CamelliaDecryptBatch(const CamelliaRecord* records, size_t count, const CamelliaKey& key,
+    std::pmr::memory_resource* resource, CamelliaRecord* results) const
+{
+    return CryptBatch(records, count, key, resource, results, true);
+}
+static void LoadBlock(const unsigned char* in, u128& x) {
+    for (size_t i = 0, j = 0; i < 4; i++, j = 4 * i)
+        x[i] = (u32)in[j] << 24 | in[j + 1] << 16 | in[j + 2] << 8 | in[j + 3];
+}
+void CamelliaKey::LoadKeyHalves(const unsigned char* key, size_t length, u128& KL, u128& KR) {
+    LoadBlock(key, KL);
     switch (length)
     {
-    case KEY_128_BIT:
-        for (size_t i = 0, j = 0; i < 4; i++, j = 4 * i)
-            this->key128[i] = KL[i] = key[j] << 24 | key[j + 1] << 16 | key[j + 2] << 8 | key[j + 3];
-        KeyGen128();
-        return;
     case KEY_192_BIT:
-        for (size_t i = 0, j = 0; i < 6; i++, j = 4 * i)
-            this->key192[i] = key[j] << 24 | key[j + 1] << 16 | key[j + 2] << 8 | key[j + 3];
-        cout << endl;
-        KR[0] = key192[4];
-        KR[1] = key192[5];
-        KR[2] = ~key192[4];
-        KR[3] = ~key192[5];
-        for (size_t i = 0; i < 4; i++)
-            this->KL[i] = key192[i];
-        KeyGen192_256();
-        KEY_MODE = 192;
-
+        KR[0] = (u32)key[16] << 24 | key[17] << 16 | key[18] << 8 | key[19];
+        KR[1] = (u32)key[20] << 24 | key[21] << 16 | key[22] << 8 | key[23];
+        KR[2] = ~KR[0];
+        KR[3] = ~KR[1];
         break;
     case KEY_256_BIT:
-        for (size_t i = 0, j = 0; i < 8; i++, j = 4 * i)
-            this->key256[i] = key[j] << 24 | key[j + 1] << 16 | key[j + 2] << 8 | key[j + 3];
-        for (size_t i = 0; i < 4; i++)
-            this->KL[i] = key256[i];
-
-        KeyGen192_256();
-        KEY_MODE = 256;
+        LoadBlock(key + 16, KR);
         break;
     }
- }
-u8 Camellia::CamelliaEncrypt(u8 text, u8 key) {
-    KeyInit(key, strlen((char*)key));
-    int length = strlen((char*)text);
-#if TEST_VECTOR
-    length = 16;
-#endif
-    return Camellia_ECB(length, text);
 }
-u8 Camellia::OneBlockCamelliaDecrypt(u64 L, u64 R) {
-
-    L ^= kw[2]; // Попереднє забілювання
-    R ^= kw[3];
-    int j = 17;
-    if (KEY_MODE == 192 || KEY_MODE == 256) {
-        j = 23;
-        for (size_t i = 0; i < 3; i++)
-        {
-            R ^= F_Func(L, k[j--]);
-            L ^= F_Func(R, k[j--]);
-        }
-        R = FLINV_Func(R, ke[4]); // FLINV
-        L = FL_Func(L, ke[5]); // FL
-    }
-
-    for (size_t i = 0; i < 3; i++){
-        R ^= F_Func(L, k[j--]);
-        L ^= F_Func(R, k[j--]);
+// Підключі з половин (старша, молодша) KL, KR та готових KA, KB
+void CamelliaKey::Expand(const u64* KL, const u64* KR, const u64* KA, const u64* KB, size_t length) {
+    if (length == KEY_192_BIT || length == KEY_256_BIT) {
+        KeyGen192_256(KL, KR, KA, KB);
+        rounds = 24;
     }
-    L = FL_Func(L, ke[3]); // FL
-    R = FLINV_Func(R, ke[2]); // FLINV
-    for (size_t i = 0; i < 3; i++) {
-        R ^= F_Func(L, k[j--]);
-        L ^= F_Func(R, k[j--]);
+    else {
+        KeyGen128(KL, KA);
+        ke[4] = ke[5] = 0; // Невикористані 128-бітним ключем
+        for (int i = 18; i < 24; i++)
+            k[i] = 0;
+        rounds = 18;
     }
-    L = FL_Func(L, ke[1]); // FL
-    R = FLINV_Func(R, ke[0]); // FLINV
-    for (size_t i = 0; i < 3; i++) {
-        R ^= F_Func(L, k[j--]);
-        L ^= F_Func(R, k[j--]);
+    FormDecryptionKeys();
+}
+CamelliaKey::CamelliaKey(const unsigned char* key, size_t length)
+{
+    if (!ValidLength(length))
+        throw std::invalid_argument("Camellia key must be 16, 24 or 32 bytes");
+    u128 KL = {}, KR = {}, KA = {}, KB = {};
+    LoadKeyHalves(key, length, KL, KR);
+    FormKA(KL, KR, KA);
+    if (length == KEY_192_BIT || length == KEY_256_BIT)
+        FormKB(KA, KR, KB);
+    const u64 kl[2] = { MaskLeft(KL), MaskRight(KL) }, kr[2] = { MaskLeft(KR), MaskRight(KR) },
+        ka[2] = { MaskLeft(KA), MaskRight(KA) }, kb[2] = { MaskLeft(KB), MaskRight(KB) };
+    Expand(kl, kr, ka, kb, length);
+}
+bool CamelliaKey::ExpandBatch(const unsigned char* keys, size_t length, size_t count, std::vector<CamelliaKey>& out) {
+    if (!ValidLength(length))
+        return false;
+    // Ключі йдуть групами по CAMELLIA_AVX2_BLOCKS: KL і KR групи - сирі байти
+    // ключів як 16-байтні блоки для SIMD-ядра, KA і KB ядро повертає половинами
+    const size_t GROUP = CAMELLIA_AVX2_BLOCKS;
+    alignas(32) unsigned char kl[GROUP * BLOCK_128_BIT], kr[GROUP * BLOCK_128_BIT];
+    alignas(32) u64 ka[2 * GROUP], kb[2 * GROUP];
+    bool withKB = length == KEY_192_BIT || length == KEY_256_BIT;
+    CamelliaKeyABFunc keyAB = CamelliaSelectedBackend().keyAB;
+    out.reserve(out.size() + count);
+    if (!keyAB) {
+        for (size_t i = 0; i < count; i++)
+            out.emplace_back(keys + i * length, length);
+        return true;
     }
 
-    R ^= kw[0]; // Фінальне забілювання
-    L ^= kw[1];
-    return BitToByte(R, L);
+    for (size_t first = 0; first < count; first += GROUP) {
+        size_t n = count - first < GROUP ? count - first : GROUP;
+        for (size_t i = 0; i < n; i++) {
+            const unsigned char* key = keys + (first + i) * length;
+            unsigned char* r = kr + i * BLOCK_128_BIT;
+            memcpy(kl + i * BLOCK_128_BIT, key, BLOCK_128_BIT);
+            switch (length)
+            {
+            case KEY_192_BIT:
+                memcpy(r, key + 16, 8);
+                for (int j = 0; j < 8; j++)
+                    r[8 + j] = (unsigned char)~key[16 + j];
+                break;
+            case KEY_256_BIT:
+                memcpy(r, key + 16, BLOCK_128_BIT);
+                break;
+            default:
+                memset(r, 0, BLOCK_128_BIT);
+            }
+        }
+        size_t done = keyAB(kl, kr, ka, withKB ? kb : nullptr, n);
+
+        for (size_t i = 0; i < n; i++) {
+            const unsigned char* l = kl + i * BLOCK_128_BIT, * r = kr + i * BLOCK_128_BIT;
+            const u64 KL[2] = { ByteToBit(l), ByteToBit((l + 8)) }, KR[2] = { ByteToBit(r), ByteToBit((r + 8)) };
+            if (i >= done) {
+                // Залишок, що не заповнив лінійки ядра, рахується скалярно
+                u128 L = {}, R = {}, A = {}, B = {};
+                LoadBlock(l, L);
+                LoadBlock(r, R);
+                FormKA(L, R, A);
+                if (withKB)
+                    FormKB(A, R, B);
+                ka[2 * i] = MaskLeft(A);
+                ka[2 * i + 1] = MaskRight(A);
+                kb[2 * i] = MaskLeft(B);
+                kb[2 * i + 1] = MaskRight(B);
+            }
+            out.emplace_back(Uninitialized());
+            out.back().Expand(KL, KR, ka + 2 * i, kb + 2 * i, length);
+        }
+    }
+    return true;
 }
-u8 Camellia::CamelliaDecrypt(u8 cipherText, u8 key) {
-    KeyInit(key, strlen((char*)key));
-    int length = strlen((char*)cipherText);
+u8 Camellia::CamelliaEncrypt(u8 text, u8 key) const {
+    size_t length = strlen((char*)text);
 #if TEST_VECTOR
     length = 16;
 #endif
-    int shift = 0;
-
-    u8 left = new unsigned char[9],
-        right = new unsigned char[9];
-    u8 decryptedText = new unsigned char[length + 1];
-    bool isOneMoreBlock = length % 16 != 0;
-    int blocksAmount = length / BLOCK_128_BIT;
-    blocksAmount += isOneMoreBlock;
-    for (size_t i = 0; i < blocksAmount; i++)
-    {
-        U8strncpy(left, cipherText + shift, 8);
-        shift += 8;
-        U8strncpy(right, cipherText + shift, 8);
-        shift += 8;
-        U8strncpy(decryptedText + shift - BLOCK_128_BIT,
-            OneBlockCamelliaDecrypt(ByteToBit(left), ByteToBit(right)), BLOCK_128_BIT);
-    }
-    decryptedText[length] = '\0';
-    return decryptedText;
+    return CamelliaEncrypt(text, length, key, strlen((char*)key));
+}
+u8 Camellia::CamelliaEncrypt(u8 text, const CamelliaKey& key) const {
+    size_t length = strlen((char*)text);
+#if TEST_VECTOR
+    length = 16;
+#endif
+    return Camellia_ECB(key, text, length, false);
+}
+u8 Camellia::CamelliaEncrypt(const unsigned char* text, size_t length, const unsigned char* key, size_t keyLength) const {
+    if (!CamelliaKey::ValidLength(keyLength))
+        return nullptr;
+    return Camellia_ECB(CamelliaKey(key, keyLength), text, length, false);
+}
+u8 Camellia::CamelliaEncrypt(const unsigned char* text, size_t length, const CamelliaKey& key) const {
+    return Camellia_ECB(key, text, length, false);
+}
+u8 Camellia::CamelliaDecrypt(u8 cipherText, u8 key) const {
+    size_t length = strlen((char*)cipherText);
+#if TEST_VECTOR
+    length = 16;
+#endif
+    return CamelliaDecrypt(cipherText, length, key, strlen((char*)key));
+}
+u8 Camellia::CamelliaDecrypt(u8 cipherText, const CamelliaKey& key) const {
+    size_t length = strlen((char*)cipherText);
+#if TEST_VECTOR
+    length = 16;
+#endif
+    return Camellia_ECB(key, cipherText, length, true);
+}
+u8 Camellia::CamelliaDecrypt(const unsigned char* cipherText, size_t length, const unsigned char* key, size_t keyLength) const {
+    if (!CamelliaKey::ValidLength(keyLength))
+        return nullptr;
+    return Camellia_ECB(CamelliaKey(key, keyLength), cipherText, length, true);
+}
+u8 Camellia::CamelliaDecrypt(const unsigned char* cipherText, size_t length, const CamelliaKey& key) const {
+    return Camellia_ECB(key, cipherText, length, true);
 }
 
 void main() {
@@ -489,23 +476,24 @@ void main() {
                                     0x00,0x00,0x00,0x00,
                                     0x00,0x00,0x00,0x00
     };
-    ConsoleHexOutput(testTextVector, "Initial text: ");
-    encryptedText = cipher->CamelliaEncrypt(testTextVector, testKeyVector);
-    ConsoleHexOutput(encryptedText, "Encrypted text: ");
-    decryptedText = cipher2->CamelliaDecrypt(encryptedText, testKeyVector);
-    ConsoleHexOutput(decryptedText, "Decrypted  text: ");
+    ConsoleHexOutput(testTextVector, BLOCK_128_BIT, "Initial text: ");
+    encryptedText = cipher->CamelliaEncrypt(testTextVector, BLOCK_128_BIT, testKeyVector, KEY_128_BIT);
+    ConsoleHexOutput(encryptedText, BLOCK_128_BIT, "Encrypted text: ");
+    decryptedText = cipher2->CamelliaDecrypt(encryptedText, BLOCK_128_BIT, testKeyVector, KEY_128_BIT);
+    ConsoleHexOutput(decryptedText, BLOCK_128_BIT, "Decrypted  text: ");
     delete cipher, cipher2;
     return;
 #endif
 
     initialText = (u8)"yehorkovalov2001";
-    ConsoleHexOutput(initialText, "Initial text: ");
+    size_t length = strlen((char*)initialText);
+    ConsoleHexOutput(initialText, length, "Initial text: ");
     
-    encryptedText = cipher->CamelliaEncrypt(initialText, (u8)"555544443333222211110000");
-    ConsoleHexOutput(encryptedText, "Encrypted text: ");
+    encryptedText = cipher->CamelliaEncrypt(initialText, length, (u8)"555544443333222211110000", KEY_192_BIT);
+    ConsoleHexOutput(encryptedText, length, "Encrypted text: ");
     
-    decryptedText = cipher2->CamelliaDecrypt(encryptedText, (u8)"555544443333222211110000");
-    ConsoleHexOutput(decryptedText, "Decrypted  text: ");
+    decryptedText = cipher2->CamelliaDecrypt(encryptedText, length, (u8)"555544443333222211110000", KEY_192_BIT);
+    ConsoleHexOutput(decryptedText, length, "Decrypted  text: ");
     delete cipher, cipher2;
 }
 
@@ -0,0 +1,247 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#define TEST_VECTOR 0
+#define BLOCK_128_BIT 16
+#define KEY_128_BIT 16
+#define KEY_192_BIT 24
+#define KEY_256_BIT 32
+
+// Скалярний шлях лише з 256-байтним SBOX1 замість 4 КБ SP-таблиць:
+// повільніший, але займає менше L1 поряд з іншим гарячим кодом
+#ifndef CAMELLIA_COMPACT_SBOX
+#define CAMELLIA_COMPACT_SBOX 0
+#endif
+
+// Бекенди пакетного шифрування, що компілюються в програму; потрібний
+// обирається під час виконання за cpuid (див. CamelliaDispatch.cpp).
+// Усі параметри тут можна задати й із системи збірки (-D / PreprocessorDefinitions)
+#ifndef CAMELLIA_AESNI
+#define CAMELLIA_AESNI 1
+#endif
+#ifndef CAMELLIA_AVX2
+#define CAMELLIA_AVX2 1
+#endif
+#ifndef CAMELLIA_SSSE3
+#define CAMELLIA_SSSE3 1
+#endif
+#ifndef CAMELLIA_BITSLICE
+#define CAMELLIA_BITSLICE 1
+#endif
+#ifndef CAMELLIA_PORTABLE
+#define CAMELLIA_PORTABLE 1
+#endif
+#ifndef CAMELLIA_AESNI_BLOCKS
+#define CAMELLIA_AESNI_BLOCKS 16
+#endif
+#ifndef CAMELLIA_AVX2_BLOCKS
+#define CAMELLIA_AVX2_BLOCKS 32
+#endif
+#ifndef CAMELLIA_SSSE3_BLOCKS
+#define CAMELLIA_SSSE3_BLOCKS 16
+#endif
+// Ширина переносного SIMD-бекенду (CamelliaSimd.h) у блоках
+#ifndef CAMELLIA_PORTABLE_BLOCKS
+#define CAMELLIA_PORTABLE_BLOCKS 8
+#endif
+// Бітсліс-шифрування 128/64 блоків без табличних звернень (constant-time);
+// залишок повних блоків доповнюється до 64 замість табличного шляху.
+// Повільніший за AES-NI/AVX2, тож автоматично не обирається
+#ifndef CAMELLIA_BITSLICE_BLOCKS
+#define CAMELLIA_BITSLICE_BLOCKS 128
+#endif
+#ifndef CAMELLIA_BITSLICE_TAIL_BLOCKS
+#define CAMELLIA_BITSLICE_TAIL_BLOCKS 64
+#endif
+// Ширини AES-NI/AVX2/SSSE3 та бітсліс-ядер закладені в самі ядра
+#if CAMELLIA_AESNI_BLOCKS != 16 || CAMELLIA_AVX2_BLOCKS != 32 || CAMELLIA_SSSE3_BLOCKS != 16 || \
+    CAMELLIA_BITSLICE_BLOCKS != 128 || CAMELLIA_BITSLICE_TAIL_BLOCKS != 64
+#error "Only CAMELLIA_PORTABLE_BLOCKS can be changed; the other widths are fixed by their kernels"
+#endif
+
+// Режим сталого часу: жодного звернення до таблиць за секретним індексом.
+// Блоки шифрує лише бітсліс-бекенд (CAMELLIA_BACKEND ігнорується), а скалярна
+// F-функція - розклад ключа (FormKA/FormKB, отже й ExpandBatch) та табличний
+// шлях, якщо бітсліс недоступний, - бере байт SBOX1 повним проходом таблиці
+// з маскою, тож розгортання ключа в цьому режимі в рази повільніше.
+// Не покриваються: час пошуку в CamelliaKeyCache (влучання видно за часом)
+// і strlen у викликах без явної довжини
+#ifndef CAMELLIA_CONSTANT_TIME
+#define CAMELLIA_CONSTANT_TIME 0
+#endif
+#if CAMELLIA_CONSTANT_TIME && !CAMELLIA_BITSLICE
+#error "CAMELLIA_CONSTANT_TIME requires CAMELLIA_BITSLICE"
+#endif
+
+typedef unsigned long long u64;
+typedef unsigned int u32;
+typedef unsigned char* u8;
+typedef u32 u128[5];
+typedef u32 u192[7];
+typedef u32 u256[9];
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTL8(x, n) ((((x) << (n)) | ((x) >> (8 - (n)))) & 0xff)
+#define ROTL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+#define MaskLeft(x) (((u64)x[0] << 32) | x[1])
+#define MaskRight(x) (((u64)x[2] << 32) | x[3])
+#define ByteToBit(x) (u64)(((u64)x[0] << 56) | ((u64)x[1] << 48) | ((u64)x[2] << 40) | ((u64)x[3] << 32) | ((u64)x[4] << 24) | ((u64)x[5] << 16)| ((u64)x[6] << 8) | ((u64)x[7] << 0))
+
+// Розгорнутий ключ: лише підключі kw/ke/k та їхній обернений розклад для
+// розшифрування. Будується один раз і далі тільки читається, тож його можна
+// передавати в будь-яку кількість викликів CamelliaEncrypt/CamelliaDecrypt,
+// зокрема з різних потоків одночасно і без синхронізації
+class alignas(64) CamelliaKey {
+    // Створити його може лише сам CamelliaKey: так ExpandBatch розгортає
+    // ключі одразу на місці в out, а ззовні неініціалізований ключ недоступний
+    class Uninitialized {
+        Uninitialized() {}
+        friend class CamelliaKey;
+    };
+public:
+    // Довжина ключа - лише 16, 24 або 32 байти; інакше std::invalid_argument
+    CamelliaKey(const unsigned char* key, size_t length);
+    explicit CamelliaKey(Uninitialized) {}
+    static bool ValidLength(size_t length) {
+        return length == KEY_128_BIT || length == KEY_192_BIT || length == KEY_256_BIT;
+    }
+    // Дописує в out розгорнуті count ключів однакової довжини, записаних підряд;
+    // F-функції KA/KB рахуються ядром keyAB вибраного бекенду для багатьох ключів
+    // одночасно, а підключі розгортаються одразу на місці в out. Бекенд без такого
+    // ядра розгортає ключі поодинці, як конструктор
+    // false і out без змін, якщо length не 16, 24 чи 32
+    static bool ExpandBatch(const unsigned char* keys, size_t length, size_t count, std::vector<CamelliaKey>& out);
+    int Rounds() const { return rounds; }
+private:
+    u64 kw[4], ke[6], k[24];
+    u64 dkw[4], dke[6], dk[24];
+    int rounds;
+
+    // Неініціалізований ключ лише як місце під копію в кеші
+    CamelliaKey() {}
+    static void LoadKeyHalves(const unsigned char* key, size_t length, u128& KL, u128& KR);
+    void Expand(const u64* KL, const u64* KR, const u64* KA, const u64* KB, size_t length);
+    // Половини (старша, молодша) KL/KR/KA/KB
+    void KeyGen128(const u64* KL, const u64* KA);
+    void KeyGen192_256(const u64* KL, const u64* KR, const u64* KA, const u64* KB);
+    static void FormKA(const u128& KL, const u128& KR, u128& KA);
+    static void FormKB(const u128& KA, const u128& KR, u128& KB);
+    void FormDecryptionKeys();
+    friend class Camellia;
+    friend class CamelliaKeyCache;
+    friend class CamelliaKeyStore;
+};
+
+// Запис пакетного шифрування: вхідні дані або результат
+struct CamelliaRecord {
+    const unsigned char* data;
+    size_t length;
+};
+
+// Не має власного стану: розмір ключа й підключі несе CamelliaKey, тож один
+// const-об'єкт можна спільно використовувати з усіх потоків
+class Camellia {
+private:
+
+#define MASK8	0xff
+#define MASK32	0xffffffff
+#define MASK64	0xffffffffffffffff
+#define MASK128	0xffffffffffffffffffffffffffffffff
+#define C1	0xA09E667F3BCC908B
+#define C2	0xB67AE8584CAA73B2
+#define C3	0xC6EF372FE94F82BE
+#define C4	0x54FF53A5F1D36F1C
+#define C5	0x10E527FADE682D1D
+#define C6	0xB05688C2B3E6C1FD
+    static u64 F_Func(u64 F_IN, u64 KE);
+    static u64 FL_Func(u64 FL_IN, u64 KE);
+    static u64 FLINV_Func(u64 FLINV_IN, u64 KE);
+    template <int J, int N> static void SixRounds(const u64* k, u64* L, u64* R);
+    template <int N> static void FLLayer(u64* L, u64* R, u64 keL, u64 keR);
+    template <int N> static void Whitening(u64* L, u64* R, u64 kwL, u64 kwR);
+    template <int ROUNDS, int N> static void CryptCore(const u64* kw, const u64* ke, const u64* k, u64* L, u64* R);
+    template <int N> size_t CryptInterleaved(const CamelliaKey& key, const unsigned char* in, unsigned char* out,
+        size_t blocks, bool decrypt) const;
+    size_t CryptBatches(const CamelliaKey& key, const unsigned char* in, unsigned char* out, size_t blocks, bool decrypt) const;
+    u8 Camellia_ECB(const CamelliaKey& key, const unsigned char* text, size_t length, bool decrypt) const;
+    bool CryptBatch(const CamelliaRecord* records, size_t count, const CamelliaKey& key,
+        std::pmr::memory_resource* resource, CamelliaRecord* results, bool decrypt) const;
+    friend class CamelliaKey;
+public:
+    // ECB-виклики з результатом u8 приймають лише повні блоки: nullptr, якщо довжина
+    // тексту не кратна 16 (для довільних довжин - CamelliaCBC_Encrypt з PKCS#7
+    // або CamelliaCTR_Crypt з CamelliaModes.h) чи ключ не 16, 24 або 32 байти.
+    // Довжини тексту та ключа визначаються через strlen
+    u8 CamelliaEncrypt(u8 text, u8 key) const;
+    u8 CamelliaDecrypt(u8 cipherText, u8 key) const;
+    // Без повторного розгортання ключа на кожен виклик
+    u8 CamelliaEncrypt(u8 text, const CamelliaKey& key) const;
+    u8 CamelliaDecrypt(u8 cipherText, const CamelliaKey& key) const;
+    // Явні довжини: довільні двійкові дані, нульові байти не обрізають ні текст, ні ключ
+    u8 CamelliaEncrypt(const unsigned char* text, size_t length, const unsigned char* key, size_t keyLength) const;
+    u8 CamelliaDecrypt(const unsigned char* cipherText, size_t length, const unsigned char* key, size_t keyLength) const;
+    u8 CamelliaEncrypt(const unsigned char* text, size_t length, const CamelliaKey& key) const;
+    u8 CamelliaDecrypt(const unsigned char* cipherText, size_t length, const CamelliaKey& key) const;
+    // Повні блоки з in одразу в буфер out викликача, без жодного виділення пам'яті;
+    // out може збігатися з in
+    void EncryptBlocks(const CamelliaKey& key, const unsigned char* in, unsigned char* out, size_t blocks) const;
+    void DecryptBlocks(const CamelliaKey& key, const unsigned char* in, unsigned char* out, size_t blocks) const;
+    // Результат записується поверх вхідних даних, без окремого буфера. Лише повні
+    // блоки: false і data без змін, якщо length не кратна 16, бо неповний блок
+    // не можна зашифрувати оборотно без зміни довжини
+    bool CamelliaEncryptInPlace(unsigned char* data, size_t length, const CamelliaKey& key) const;
+    bool CamelliaDecryptInPlace(unsigned char* data, size_t length, const CamelliaKey& key) const;
+    // Результати всіх записів пакета лягають одним виділенням у resource
+    // (наприклад, std::pmr::monotonic_buffer_resource) і звільняються разом з ним;
+    // results[i] вказує на результат records[i]. Лише повні блоки: false без
+    // виділення і без запису в results, якщо довжина будь-якого запису не кратна 16
+    bool CamelliaEncryptBatch(const CamelliaRecord* records, size_t count, const CamelliaKey& key,
+        std::pmr::memory_resource* resource, CamelliaRecord* results) const;
+    bool CamelliaDecryptBatch(const CamelliaRecord* records, size_t count, const CamelliaKey& key,
+        std::pmr::memory_resource* resource, CamelliaRecord* results) const;
+};
+
+// Ядра отримують підключі в порядку використання: для розшифрування
+// передається обернений розклад dkw/dke/dk з CamelliaKey
+void CamelliaAESNI_Crypt16(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out);
+void CamelliaAVX2_Crypt32(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out);
+void CamelliaSSSE3_Crypt16(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out);
+void CamelliaBitslice_Crypt64(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out);
+void CamelliaBitslice_Crypt128(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out);
+void CamelliaPortable_Crypt(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out);
+// KA (та KB, якщо kb != nullptr) для 16/32 ключів за блоками KL і KR;
+// результат ключа i - половини (старша, молодша) у ka[2i], ka[2i + 1]
+void CamelliaAESNI_KeyAB16(const unsigned char* kl, const unsigned char* kr, u64* ka, u64* kb);
+void CamelliaAVX2_KeyAB32(const unsigned char* kl, const unsigned char* kr, u64* ka, u64* kb);
+
+// Можливості процесора, визначені через cpuid при першому зверненні
+struct CamelliaCpuFeatures {
+    bool sse2, ssse3, aesni, avx2, pclmul;
+};
+const CamelliaCpuFeatures& CamelliaCpu();
+
+// Шифрує стільки повних блоків, скільки вміщує ядро бекенду, і повертає їх кількість
+typedef size_t(*CamelliaBatchFunc)(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out, size_t blocks);
+// Те саме для KA/KB розкладу ключів: повертає кількість оброблених ключів;
+// nullptr у бекенда без такого ядра - тоді ExpandBatch розгортає ключі поодинці
+typedef size_t(*CamelliaKeyABFunc)(const unsigned char* kl, const unsigned char* kr,
+    u64* ka, u64* kb, size_t keys);
+struct CamelliaBackend {
+    const char* name;
+    CamelliaBatchFunc crypt;
+    CamelliaKeyABFunc keyAB;
+};
+// Найшвидший бекенд, доступний на процесорі; вибір робиться один раз
+// потокобезпечною ініціалізацією статичної змінної. Змінна середовища
+// CAMELLIA_BACKEND=scalar|ssse3|aesni|avx2|portable|bitslice закріплює конкретний
+const CamelliaBackend& CamelliaSelectedBackend();
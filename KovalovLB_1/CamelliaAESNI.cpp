@@ -0,0 +1,81 @@
+#include "CamelliaByteslice.h"
+
+// S-блоки Camellia афінно еквівалентні S-блоку AES:
+//   s1(x) = post(SubBytes(pre(x))), s4(x) = s1(x <<< 1),
+//   s2(x) = s1(x) <<< 1, s3(x) = s1(x) >>> 1,
+// тому SubBytes виконує AESENCLAST, а афінні pre/post рахуються
+// двома PSHUFB-таблицями по молодшому та старшому півбайту.
+alignas(16) static const unsigned char PRE_S1_LO[16] = {
+    0x08, 0x09, 0x11, 0x10, 0xb9, 0xb8, 0xa0, 0xa1, 0xa3, 0xa2, 0xba, 0xbb, 0x12, 0x13, 0x0b, 0x0a };
+alignas(16) static const unsigned char PRE_S1_HI[16] = {
+    0x00, 0xa7, 0x93, 0x34, 0x61, 0xc6, 0xf2, 0x55, 0xd9, 0x7e, 0x4a, 0xed, 0xb8, 0x1f, 0x2b, 0x8c };
+alignas(16) static const unsigned char PRE_S4_LO[16] = {
+    0x08, 0x11, 0xb9, 0xa0, 0xa3, 0xba, 0x12, 0x0b, 0xaf, 0xb6, 0x1e, 0x07, 0x04, 0x1d, 0xb5, 0xac };
+alignas(16) static const unsigned char PRE_S4_HI[16] = {
+    0x00, 0x93, 0x61, 0xf2, 0xd9, 0x4a, 0xb8, 0x2b, 0x01, 0x92, 0x60, 0xf3, 0xd8, 0x4b, 0xb9, 0x2a };
+alignas(16) static const unsigned char POST_S1_LO[16] = {
+    0x11, 0x82, 0x84, 0x17, 0x3e, 0xad, 0xab, 0x38, 0x71, 0xe2, 0xe4, 0x77, 0x5e, 0xcd, 0xcb, 0x58 };
+alignas(16) static const unsigned char POST_S1_HI[16] = {
+    0x00, 0xb8, 0xd9, 0x61, 0xa0, 0x18, 0x79, 0xc1, 0xa8, 0x10, 0x71, 0xc9, 0x08, 0xb0, 0xd1, 0x69 };
+alignas(16) static const unsigned char POST_S2_LO[16] = {
+    0x22, 0x05, 0x09, 0x2e, 0x7c, 0x5b, 0x57, 0x70, 0xe2, 0xc5, 0xc9, 0xee, 0xbc, 0x9b, 0x97, 0xb0 };
+alignas(16) static const unsigned char POST_S2_HI[16] = {
+    0x00, 0x71, 0xb3, 0xc2, 0x41, 0x30, 0xf2, 0x83, 0x51, 0x20, 0xe2, 0x93, 0x10, 0x61, 0xa3, 0xd2 };
+alignas(16) static const unsigned char POST_S3_LO[16] = {
+    0x88, 0x41, 0x42, 0x8b, 0x1f, 0xd6, 0xd5, 0x1c, 0xb8, 0x71, 0x72, 0xbb, 0x2f, 0xe6, 0xe5, 0x2c };
+alignas(16) static const unsigned char POST_S3_HI[16] = {
+    0x00, 0x5c, 0xec, 0xb0, 0x50, 0x0c, 0xbc, 0xe0, 0x54, 0x08, 0xb8, 0xe4, 0x04, 0x58, 0xe8, 0xb4 };
+// Компенсує ShiftRows всередині AESENCLAST
+alignas(16) static const unsigned char INV_SHIFT_ROWS[16] = {
+    0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3 };
+alignas(16) static const unsigned char LOW_NIBBLE[16] = {
+    0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f };
+
+static inline __m128i VAesLast(__m128i a) { return _mm_aesenclast_si128(a, _mm_setzero_si128()); }
+static inline __m256i VAesLast(__m256i a) {
+    // VAESENCLAST для ymm потребує VAES, тому половини обробляються окремо
+    __m128i lo = _mm_aesenclast_si128(_mm256_castsi256_si128(a), _mm_setzero_si128());
+    __m128i hi = _mm_aesenclast_si128(_mm256_extracti128_si256(a, 1), _mm_setzero_si128());
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+template <typename V>
+struct AesniSBoxes {
+    V preS1Lo, preS1Hi, preS4Lo, preS4Hi;
+    V postS1Lo, postS1Hi, postS2Lo, postS2Hi, postS3Lo, postS3Hi;
+    V invShiftRows, lowNibble;
+
+    AesniSBoxes() :
+        preS1Lo(VTable<V>(PRE_S1_LO)), preS1Hi(VTable<V>(PRE_S1_HI)),
+        preS4Lo(VTable<V>(PRE_S4_LO)), preS4Hi(VTable<V>(PRE_S4_HI)),
+        postS1Lo(VTable<V>(POST_S1_LO)), postS1Hi(VTable<V>(POST_S1_HI)),
+        postS2Lo(VTable<V>(POST_S2_LO)), postS2Hi(VTable<V>(POST_S2_HI)),
+        postS3Lo(VTable<V>(POST_S3_LO)), postS3Hi(VTable<V>(POST_S3_HI)),
+        invShiftRows(VTable<V>(INV_SHIFT_ROWS)), lowNibble(VTable<V>(LOW_NIBBLE)) {}
+
+    V Inverse(V x, V preLo, V preHi) const {
+        x = Filter(x, preLo, preHi, lowNibble);
+        return VAesLast(VShuffle(x, invShiftRows));
+    }
+    V S1(V x) const { return Filter(Inverse(x, preS1Lo, preS1Hi), postS1Lo, postS1Hi, lowNibble); }
+    V S2(V x) const { return Filter(Inverse(x, preS1Lo, preS1Hi), postS2Lo, postS2Hi, lowNibble); }
+    V S3(V x) const { return Filter(Inverse(x, preS1Lo, preS1Hi), postS3Lo, postS3Hi, lowNibble); }
+    V S4(V x) const { return Filter(Inverse(x, preS4Lo, preS4Hi), postS1Lo, postS1Hi, lowNibble); }
+};
+
+void CamelliaAESNI_Crypt16(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out)
+{
+    CamelliaByteSliced<__m128i, AesniSBoxes<__m128i> >(kw, ke, k, rounds, in, out);
+}
+void CamelliaAVX2_Crypt32(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out)
+{
+    CamelliaByteSliced<__m256i, AesniSBoxes<__m256i> >(kw, ke, k, rounds, in, out);
+}
+void CamelliaAESNI_KeyAB16(const unsigned char* kl, const unsigned char* kr, u64* ka, u64* kb) {
+    CamelliaByteSlicedKeyAB<__m128i, AesniSBoxes<__m128i> >(kl, kr, ka, kb);
+}
+void CamelliaAVX2_KeyAB32(const unsigned char* kl, const unsigned char* kr, u64* ka, u64* kb) {
+    CamelliaByteSlicedKeyAB<__m256i, AesniSBoxes<__m256i> >(kl, kr, ka, kb);
+}
@@ -0,0 +1,280 @@
+#include "Camellia.h"
+#include <cstring>
+#include <emmintrin.h>
+
+// Бітсліс-реалізація: кожен із 128 бітів блока зберігається окремим словом,
+// у якому біт b належить блоку b. S-блоки рахуються як булеві схеми без
+// звернень до таблиць, тому час виконання не залежить від даних і ключа.
+//
+// s1(x) = post(inv(pre(x))), де inv - обернення в GF((2^4)^2) з
+// GF(16) = GF(2)[x]/(x^4 + x + 1) та Y^2 = Y + x^3, а pre/post - афінні
+// перетворення. s2, s3 та s4 - циклічні зсуви виходу чи входу s1,
+// тобто лише перенумерація бітових площин.
+//
+// Ціна - ~200 логічних операцій на S-блок на всі блоки пакета разом
+// (множення в GF(16) за Карацубою, 9 AND) та транспонування площин через
+// SSE2: разом це на рівні скалярного табличного шляху, але без таблиць.
+
+struct Lanes128 {
+    __m128i v;
+};
+static inline Lanes128 operator^(Lanes128 a, Lanes128 b) { return { _mm_xor_si128(a.v, b.v) }; }
+static inline Lanes128 operator&(Lanes128 a, Lanes128 b) { return { _mm_and_si128(a.v, b.v) }; }
+static inline Lanes128 operator|(Lanes128 a, Lanes128 b) { return { _mm_or_si128(a.v, b.v) }; }
+static inline Lanes128 operator~(Lanes128 a) { return { _mm_xor_si128(a.v, _mm_set1_epi32(-1)) }; }
+
+template <typename W> struct BitsliceWord;
+template <> struct BitsliceWord<u64> {
+    static u64 Fill(u64 bit) { return 0 - bit; }
+};
+template <> struct BitsliceWord<Lanes128> {
+    static Lanes128 Fill(u64 bit) { return { _mm_set1_epi32((int)(0 - (u32)bit)) }; }
+};
+
+// Транспонування 16x16 байтів: чотири однакові кроки розпакування рядків i та i + 8
+static inline void TransposeBytes16(__m128i* x) {
+    for (int r = 0; r < 4; r++) {
+        __m128i y[16];
+        for (int i = 0; i < 8; i++) {
+            y[2 * i] = _mm_unpacklo_epi8(x[i], x[i + 8]);
+            y[2 * i + 1] = _mm_unpackhi_epi8(x[i], x[i + 8]);
+        }
+        for (int i = 0; i < 16; i++)
+            x[i] = y[i];
+    }
+}
+
+// Транспонування бітів 16 рядків по BYTES байтів: біт t байта k рядка i стає
+// бітом i 16-бітного слова dst[8 * k + t]. Після транспонування байтів
+// PMOVMSKB забирає один біт одразу з 16 рядків
+template <int BYTES>
+static inline void TransposeBits16(const unsigned char* const* rows, unsigned char* const* dst) {
+    __m128i x[16];
+    for (int i = 0; i < 16; i++)
+        x[i] = BYTES == 16 ? _mm_loadu_si128((const __m128i*)rows[i]) : _mm_loadl_epi64((const __m128i*)rows[i]);
+    TransposeBytes16(x);
+    for (int k = 0; k < BYTES; k++) {
+        for (int t = 7; t >= 0; t--) {
+            unsigned short bits = (unsigned short)_mm_movemask_epi8(x[k]);
+            memcpy(dst[8 * k + t], &bits, 2);
+            x[k] = _mm_add_epi8(x[k], x[k]);
+        }
+    }
+}
+
+// Площина біта t байта k блока (порядок площин див. RoundF)
+static inline int PlaneOf(int k, int t) {
+    return k < 8 ? 8 * (7 - k) + t : 64 + 8 * (15 - k) + t;
+}
+
+// Біт b площини - блок b: 16 блоків за раз дають по 16 бітів кожної площини
+template <typename W>
+static void LoadPlanes(const unsigned char* in, W* s) {
+    const unsigned char* rows[16];
+    unsigned char* dst[128];
+    for (int c = 0; c < (int)sizeof(W) / 2; c++) {
+        for (int i = 0; i < 16; i++)
+            rows[i] = in + (16 * c + i) * BLOCK_128_BIT;
+        for (int r = 0; r < 128; r++)
+            dst[r] = (unsigned char*)&s[PlaneOf(r / 8, r % 8)] + 2 * c;
+        TransposeBits16<16>(rows, dst);
+    }
+}
+
+// Зворотне транспонування: 16 площин за раз дають по 16 бітів кожного блока.
+// Шифротекст - R || L, тому половини міняються місцями (байт k ^ 8)
+template <typename W>
+static void StorePlanes(const W* s, unsigned char* out) {
+    const unsigned char* rows[16];
+    unsigned char* dst[128];
+    for (int c = 0; c < 8; c++) {
+        for (int i = 0; i < 16; i++)
+            rows[i] = (const unsigned char*)&s[PlaneOf(((16 * c + i) / 8) ^ 8, (16 * c + i) % 8)];
+        for (int b = 0; b < 8 * (int)sizeof(W); b++)
+            dst[b] = out + b * BLOCK_128_BIT + 2 * c;
+        TransposeBits16<sizeof(W)>(rows, dst);
+    }
+}
+
+// Вхід читається як x <<< IN (біт i - це біт (i - IN) mod 8 значення x),
+// тож обертання входу s4 не потребує копії площин
+template <int IN, typename W>
+static inline void PreS1(const W* x, W* y) {
+#define X(i) x[((i) + 8 - IN) & 7]
+    y[0] = X(0) ^ X(1) ^ X(2) ^ X(3) ^ X(4);
+    y[1] = X(4);
+    y[2] = ~(X(2) ^ X(3) ^ X(4));
+    y[3] = ~(X(2) ^ X(3) ^ X(5));
+    y[4] = X(1) ^ X(3) ^ X(4) ^ X(5);
+    y[5] = X(1) ^ X(5) ^ X(6) ^ X(7);
+    y[6] = ~(X(1) ^ X(3) ^ X(4) ^ X(5) ^ X(6));
+    y[7] = X(5) ^ X(6) ^ X(7);
+#undef X
+}
+
+// Вихід записується як y <<< OUT: обертання s2 і s3 - це лише інші номери площин
+template <int OUT, typename W>
+static inline void PostS1(const W* x, W* y) {
+#define Y(i) y[((i) + OUT) & 7]
+    Y(0) = x[0] ^ x[2] ^ x[3] ^ x[4] ^ x[5] ^ x[6] ^ x[7];
+    Y(1) = ~(x[2] ^ x[3] ^ x[5]);
+    Y(2) = ~(x[1] ^ x[2] ^ x[4] ^ x[6]);
+    Y(3) = ~(x[1] ^ x[3] ^ x[4] ^ x[5] ^ x[7]);
+    Y(4) = x[0] ^ x[1] ^ x[2] ^ x[3] ^ x[5] ^ x[7];
+    Y(5) = ~(x[0] ^ x[5] ^ x[7]);
+    Y(6) = ~(x[0] ^ x[1] ^ x[3] ^ x[6] ^ x[7]);
+    Y(7) = x[0] ^ x[3] ^ x[4] ^ x[5] ^ x[6];
+#undef Y
+}
+
+// Множення в GF(16) за Карацубою над парами бітів: 9 AND замість 16,
+// потім редукція за x^4 = x + 1. Розписане явно, щоб площини лишалися в регістрах
+template <typename W>
+static inline void GF16Mul(const W* a, const W* b, W* c) {
+    W lo0 = a[0] & b[0], lo2 = a[1] & b[1];
+    W lo1 = ((a[0] ^ a[1]) & (b[0] ^ b[1])) ^ lo0 ^ lo2;
+    W hi0 = a[2] & b[2], hi2 = a[3] & b[3];
+    W hi1 = ((a[2] ^ a[3]) & (b[2] ^ b[3])) ^ hi0 ^ hi2;
+    W s0 = a[0] ^ a[2], s1 = a[1] ^ a[3], t0 = b[0] ^ b[2], t1 = b[1] ^ b[3];
+    W mid0 = s0 & t0, mid2 = s1 & t1;
+    W mid1 = ((s0 ^ s1) & (t0 ^ t1)) ^ mid0 ^ mid2;
+    mid0 = mid0 ^ lo0 ^ hi0;
+    mid1 = mid1 ^ lo1 ^ hi1;
+    mid2 = mid2 ^ lo2 ^ hi2;
+    // Добуток p0..p6: p0 = lo0, p1 = lo1, p2 = lo2 ^ mid0, p3 = mid1,
+    // p4 = hi0 ^ mid2, p5 = hi1, p6 = hi2
+    W p4 = hi0 ^ mid2;
+    c[0] = lo0 ^ p4;
+    c[1] = lo1 ^ p4 ^ hi1;
+    c[2] = lo2 ^ mid0 ^ hi1 ^ hi2;
+    c[3] = mid1 ^ hi2;
+}
+
+template <typename W>
+static inline void GF16Inv(const W* a, W* b) {
+    W a01 = a[0] & a[1], a02 = a[0] & a[2], a12 = a[1] & a[2];
+    W a03 = a[0] & a[3], a13 = a[1] & a[3], a23 = a[2] & a[3];
+    W a012 = a01 & a[2], a123 = a12 & a[3];
+    b[0] = a[0] ^ a[1] ^ a[2] ^ a[3] ^ a02 ^ a12 ^ a012 ^ a123;
+    b[1] = a01 ^ a02 ^ a12 ^ a[3] ^ a13 ^ (a01 & a[3]);
+    b[2] = a01 ^ a[2] ^ a02 ^ a[3] ^ a03 ^ (a02 & a[3]);
+    b[3] = a[1] ^ a[2] ^ a[3] ^ a03 ^ a13 ^ a23 ^ a123;
+}
+
+// x = h*Y + l, x^-1 = (h/d)*Y + (h + l)/d, d = x^3*h^2 + h*l + l^2
+template <typename W>
+static inline void TowerInv(const W* x, W* y) {
+    const W* l = x;
+    const W* h = x + 4;
+    W hl[4], d[4], di[4], sum[4];
+    GF16Mul(h, l, hl);
+    d[0] = h[2] ^ hl[0] ^ l[0] ^ l[2];
+    d[1] = h[1] ^ h[2] ^ h[3] ^ hl[1] ^ l[2];
+    d[2] = h[1] ^ hl[2] ^ l[1] ^ l[3];
+    d[3] = h[0] ^ h[2] ^ h[3] ^ hl[3] ^ l[3];
+    GF16Inv(d, di);
+    sum[0] = h[0] ^ l[0];
+    sum[1] = h[1] ^ l[1];
+    sum[2] = h[2] ^ l[2];
+    sum[3] = h[3] ^ l[3];
+    GF16Mul(h, di, y + 4);
+    GF16Mul(sum, di, y);
+}
+
+// s1(x) = post(inv(pre(x))); s2 = s1 <<< 1, s3 = s1 >>> 1, s4(x) = s1(x <<< 1)
+template <int IN, int OUT, typename W>
+static inline void SBox(const W* x, W* y) {
+    W t[8], u[8];
+    PreS1<IN>(x, t);
+    TowerInv(t, u);
+    PostS1<OUT>(u, y);
+}
+
+// Площини L - s[0..63], R - s[64..127]; площина j відповідає біту j слова.
+// Байт m (старший першим) займає площини 8 * (7 - m) ... 8 * (7 - m) + 7.
+template <typename W>
+static inline void RoundF(const W* in, W* out, u64 key) {
+    W x[8][8], z[8][8];
+    for (int m = 0; m < 8; m++) {
+        int base = 8 * (7 - m);
+        for (int t = 0; t < 8; t++)
+            x[m][t] = in[base + t] ^ BitsliceWord<W>::Fill((key >> (base + t)) & 1);
+    }
+    SBox<0, 0>(x[0], z[0]);
+    SBox<0, 1>(x[1], z[1]);
+    SBox<0, 7>(x[2], z[2]);
+    SBox<1, 0>(x[3], z[3]);
+    SBox<0, 1>(x[4], z[4]);
+    SBox<0, 7>(x[5], z[5]);
+    SBox<1, 0>(x[6], z[6]);
+    SBox<0, 0>(x[7], z[7]);
+
+    for (int t = 0; t < 8; t++) {
+        W temp = z[0][t] ^ z[1][t] ^ z[2][t] ^ z[3][t] ^ z[4][t] ^ z[5][t] ^ z[6][t] ^ z[7][t];
+        out[56 + t] = out[56 + t] ^ temp ^ z[1][t] ^ z[4][t];
+        out[48 + t] = out[48 + t] ^ temp ^ z[2][t] ^ z[5][t];
+        out[40 + t] = out[40 + t] ^ temp ^ z[3][t] ^ z[6][t];
+        out[32 + t] = out[32 + t] ^ temp ^ z[0][t] ^ z[7][t];
+        out[24 + t] = out[24 + t] ^ temp ^ z[2][t] ^ z[3][t] ^ z[4][t];
+        out[16 + t] = out[16 + t] ^ temp ^ z[0][t] ^ z[3][t] ^ z[5][t];
+        out[8 + t] = out[8 + t] ^ temp ^ z[0][t] ^ z[1][t] ^ z[6][t];
+        out[t] = out[t] ^ temp ^ z[1][t] ^ z[2][t] ^ z[7][t];
+    }
+}
+
+template <typename W>
+static inline void AddKey(W* x, u64 key) {
+    for (int i = 0; i < 64; i++)
+        x[i] = x[i] ^ BitsliceWord<W>::Fill((key >> i) & 1);
+}
+
+// Старша половина x1 - площини 32..63, молодша x2 - 0..31
+template <typename W>
+static inline void FL(W* x, u64 key) {
+    for (int i = 0; i < 32; i++)
+        x[i] = x[i] ^ (x[32 + ((i + 31) & 31)] & BitsliceWord<W>::Fill((key >> (32 + ((i + 31) & 31))) & 1));
+    for (int i = 0; i < 32; i++)
+        x[32 + i] = x[32 + i] ^ (x[i] | BitsliceWord<W>::Fill((key >> i) & 1));
+}
+
+template <typename W>
+static inline void FLINV(W* y, u64 key) {
+    for (int i = 0; i < 32; i++)
+        y[32 + i] = y[32 + i] ^ (y[i] | BitsliceWord<W>::Fill((key >> i) & 1));
+    for (int i = 0; i < 32; i++)
+        y[i] = y[i] ^ (y[32 + ((i + 31) & 31)] & BitsliceWord<W>::Fill((key >> (32 + ((i + 31) & 31))) & 1));
+}
+
+template <typename W>
+static void CamelliaBitsliced(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out)
+{
+    W s[128];
+    LoadPlanes(in, s);
+
+    AddKey(s, kw[0]);
+    AddKey(s + 64, kw[1]);
+    for (int i = 0; i < rounds; i += 2) {
+        if (i > 0 && i % 6 == 0) {
+            FL(s, ke[i / 3 - 2]);
+            FLINV(s + 64, ke[i / 3 - 1]);
+        }
+        RoundF(s, s + 64, k[i]);
+        RoundF(s + 64, s, k[i + 1]);
+    }
+    AddKey(s + 64, kw[2]);
+    AddKey(s, kw[3]);
+
+    StorePlanes(s, out);
+}
+
+void CamelliaBitslice_Crypt64(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out)
+{
+    CamelliaBitsliced<u64>(kw, ke, k, rounds, in, out);
+}
+void CamelliaBitslice_Crypt128(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out)
+{
+    CamelliaBitsliced<Lanes128>(kw, ke, k, rounds, in, out);
+}
@@ -0,0 +1,217 @@
+#pragma once
+#include "Camellia.h"
+#include <immintrin.h>
+
+// Спільне байтсліс-ядро для SIMD-бекендів: регістр j містить j-й байт
+// кожного блоку, а S-блоки надає політика S з методами S1..S4
+static inline __m128i VXor(__m128i a, __m128i b) { return _mm_xor_si128(a, b); }
+static inline __m128i VAnd(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+static inline __m128i VOr(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+static inline __m128i VShl1(__m128i a) { return _mm_add_epi8(a, a); }
+static inline __m128i VSrl16(__m128i a, int n) { return _mm_srli_epi16(a, n); }
+static inline __m128i VShuffle(__m128i table, __m128i index) { return _mm_shuffle_epi8(table, index); }
+static inline __m128i VUnpackLo(__m128i a, __m128i b) { return _mm_unpacklo_epi8(a, b); }
+static inline __m128i VUnpackHi(__m128i a, __m128i b) { return _mm_unpackhi_epi8(a, b); }
+
+static inline __m256i VXor(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+static inline __m256i VAnd(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+static inline __m256i VOr(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+static inline __m256i VShl1(__m256i a) { return _mm256_add_epi8(a, a); }
+static inline __m256i VSrl16(__m256i a, int n) { return _mm256_srli_epi16(a, n); }
+static inline __m256i VShuffle(__m256i table, __m256i index) { return _mm256_shuffle_epi8(table, index); }
+static inline __m256i VUnpackLo(__m256i a, __m256i b) { return _mm256_unpacklo_epi8(a, b); }
+static inline __m256i VUnpackHi(__m256i a, __m256i b) { return _mm256_unpackhi_epi8(a, b); }
+
+template <typename V> V VSet1(int b);
+template <> inline __m128i VSet1<__m128i>(int b) { return _mm_set1_epi8((char)b); }
+template <> inline __m256i VSet1<__m256i>(int b) { return _mm256_set1_epi8((char)b); }
+
+template <typename V> V VTable(const unsigned char* table);
+template <> inline __m128i VTable<__m128i>(const unsigned char* table) {
+    return _mm_load_si128((const __m128i*)table);
+}
+template <> inline __m256i VTable<__m256i>(const unsigned char* table) {
+    return _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)table));
+}
+
+// Блок i лягає в i-й регістр; у AVX2 верхня 128-бітна половина містить блок 16 + i
+template <typename V> V VLoadBlock(const unsigned char* in, int i);
+template <> inline __m128i VLoadBlock<__m128i>(const unsigned char* in, int i) {
+    return _mm_loadu_si128((const __m128i*)(in + i * BLOCK_128_BIT));
+}
+template <> inline __m256i VLoadBlock<__m256i>(const unsigned char* in, int i) {
+    __m128i lo = _mm_loadu_si128((const __m128i*)(in + i * BLOCK_128_BIT));
+    __m128i hi = _mm_loadu_si128((const __m128i*)(in + (16 + i) * BLOCK_128_BIT));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+inline void VStoreBlock(unsigned char* out, int i, __m128i x) {
+    _mm_storeu_si128((__m128i*)(out + i * BLOCK_128_BIT), x);
+}
+inline void VStoreBlock(unsigned char* out, int i, __m256i x) {
+    _mm_storeu_si128((__m128i*)(out + i * BLOCK_128_BIT), _mm256_castsi256_si128(x));
+    _mm_storeu_si128((__m128i*)(out + (16 + i) * BLOCK_128_BIT), _mm256_extracti128_si256(x, 1));
+}
+
+// Афінне перетворення байта двома PSHUFB-таблицями по півбайтах
+template <typename V>
+static inline V Filter(V x, V lo, V hi, V lowNibble) {
+    return VXor(VShuffle(lo, VAnd(x, lowNibble)), VShuffle(hi, VAnd(VSrl16(x, 4), lowNibble)));
+}
+
+// 16x16 транспонування байтів у кожній 128-бітній половині:
+// чотири ідеальні перемішування переставляють індекс рядка та стовпця
+template <typename V>
+static void Transpose(V* x) {
+    V y[16];
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < 8; i++) {
+            y[2 * i] = VUnpackLo(x[i], x[i + 8]);
+            y[2 * i + 1] = VUnpackHi(x[i], x[i + 8]);
+        }
+        for (int i = 0; i < 16; i++)
+            x[i] = y[i];
+    }
+}
+
+template <typename V>
+static inline void AddKey(V* x, u64 key) {
+    for (int i = 0; i < 8; i++)
+        x[i] = VXor(x[i], VSet1<V>((int)(key >> (56 - 8 * i)) & MASK8));
+}
+
+template <typename V, typename S>
+static inline void RoundF(const V* in, V* out, u64 key, const S& sbox) {
+    V z[8];
+    for (int i = 0; i < 8; i++)
+        z[i] = VXor(in[i], VSet1<V>((int)(key >> (56 - 8 * i)) & MASK8));
+
+    z[0] = sbox.S1(z[0]);
+    z[1] = sbox.S2(z[1]);
+    z[2] = sbox.S3(z[2]);
+    z[3] = sbox.S4(z[3]);
+    z[4] = sbox.S2(z[4]);
+    z[5] = sbox.S3(z[5]);
+    z[6] = sbox.S4(z[6]);
+    z[7] = sbox.S1(z[7]);
+
+    V temp = VXor(VXor(VXor(z[0], z[1]), VXor(z[2], z[3])), VXor(VXor(z[4], z[5]), VXor(z[6], z[7])));
+    out[0] = VXor(out[0], VXor(temp, VXor(z[1], z[4])));
+    out[1] = VXor(out[1], VXor(temp, VXor(z[2], z[5])));
+    out[2] = VXor(out[2], VXor(temp, VXor(z[3], z[6])));
+    out[3] = VXor(out[3], VXor(temp, VXor(z[0], z[7])));
+    out[4] = VXor(out[4], VXor(temp, VXor(z[2], VXor(z[3], z[4]))));
+    out[5] = VXor(out[5], VXor(temp, VXor(z[0], VXor(z[3], z[5]))));
+    out[6] = VXor(out[6], VXor(temp, VXor(z[0], VXor(z[1], z[6]))));
+    out[7] = VXor(out[7], VXor(temp, VXor(z[1], VXor(z[2], z[7]))));
+}
+
+// Циклічний зсув на 1 біт 32-бітного слова, розкладеного по 4 байтових регістрах
+template <typename V>
+static inline void Rotl1Xor(const V* a, V* out) {
+    V one = VSet1<V>(1);
+    for (int i = 0; i < 4; i++)
+        out[i] = VXor(out[i], VOr(VShl1(a[i]), VAnd(VSrl16(a[(i + 1) & 3], 7), one)));
+}
+
+template <typename V>
+static inline void FL(V* x, u64 key) {
+    V a[4];
+    for (int i = 0; i < 4; i++)
+        a[i] = VAnd(x[i], VSet1<V>((int)(key >> (56 - 8 * i)) & MASK8));
+    Rotl1Xor(a, x + 4);
+    for (int i = 0; i < 4; i++)
+        x[i] = VXor(x[i], VOr(x[4 + i], VSet1<V>((int)(key >> (24 - 8 * i)) & MASK8)));
+}
+
+template <typename V>
+static inline void FLINV(V* y, u64 key) {
+    for (int i = 0; i < 4; i++)
+        y[i] = VXor(y[i], VOr(y[4 + i], VSet1<V>((int)(key >> (24 - 8 * i)) & MASK8)));
+    V a[4];
+    for (int i = 0; i < 4; i++)
+        a[i] = VAnd(y[i], VSet1<V>((int)(key >> (56 - 8 * i)) & MASK8));
+    Rotl1Xor(a, y + 4);
+}
+
+template <typename V, typename S>
+static void CamelliaByteSliced(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out)
+{
+    S sbox;
+    V x[16];
+    for (int i = 0; i < 16; i++)
+        x[i] = VLoadBlock<V>(in, i);
+    Transpose(x);
+
+    AddKey(x, kw[0]);
+    AddKey(x + 8, kw[1]);
+    for (int i = 0; i < rounds; i += 2) {
+        if (i > 0 && i % 6 == 0) {
+            FL(x, ke[i / 3 - 2]);
+            FLINV(x + 8, ke[i / 3 - 1]);
+        }
+        RoundF(x, x + 8, k[i], sbox);
+        RoundF(x + 8, x, k[i + 1], sbox);
+    }
+    AddKey(x + 8, kw[2]);
+    AddKey(x, kw[3]);
+
+    V y[16];
+    for (int i = 0; i < 8; i++) {
+        y[i] = x[8 + i];
+        y[8 + i] = x[i];
+    }
+    Transpose(y);
+    for (int i = 0; i < 16; i++)
+        VStoreBlock(out, i, y[i]);
+}
+
+// Переставляє байти кожної 64-бітної половини блоку: big-endian половина
+// ключа після збереження читається як u64 на little-endian процесорі
+alignas(16) static const unsigned char BSWAP64[16] = {
+    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 };
+
+// KA та KB (RFC 3713, 2.2) для 16/32 ключів одночасно: KL і KR - 16-байтні
+// big-endian блоки, що лягають у лінійки так само, як блоки даних; KA і KB
+// ключа i записуються як половини (старша, молодша) у ka[2i], ka[2i + 1].
+// kb = nullptr для 128-бітних ключів, яким потрібен лише KA
+template <typename V, typename S>
+static void CamelliaByteSlicedKeyAB(const unsigned char* kl, const unsigned char* kr, u64* ka, u64* kb)
+{
+    S sbox;
+    const V bswap = VTable<V>(BSWAP64);
+    V l[16], r[16], x[16];
+    for (int i = 0; i < 16; i++) {
+        l[i] = VLoadBlock<V>(kl, i);
+        r[i] = VLoadBlock<V>(kr, i);
+    }
+    Transpose(l);
+    Transpose(r);
+
+    for (int i = 0; i < 16; i++)
+        x[i] = VXor(l[i], r[i]);
+    RoundF(x, x + 8, C1, sbox);
+    RoundF(x + 8, x, C2, sbox);
+    for (int i = 0; i < 16; i++)
+        x[i] = VXor(x[i], l[i]);
+    RoundF(x, x + 8, C3, sbox);
+    RoundF(x + 8, x, C4, sbox);
+
+    V y[16];
+    for (int i = 0; i < 16; i++)
+        y[i] = x[i];
+    Transpose(y);
+    for (int i = 0; i < 16; i++)
+        VStoreBlock((unsigned char*)ka, i, VShuffle(y[i], bswap));
+    if (!kb)
+        return;
+
+    for (int i = 0; i < 16; i++)
+        x[i] = VXor(x[i], r[i]);
+    RoundF(x, x + 8, C5, sbox);
+    RoundF(x + 8, x, C6, sbox);
+    Transpose(x);
+    for (int i = 0; i < 16; i++)
+        VStoreBlock((unsigned char*)kb, i, VShuffle(x[i], bswap));
+}
@@ -0,0 +1,82 @@
+#include "CamelliaModes.h"
+
+void CamelliaCBC_EncryptBlocks(const CamelliaKey& key, unsigned char* iv,
+    const unsigned char* in, unsigned char* out, size_t blocks)
+{
+    const Camellia cipher;
+    const unsigned char* chain = iv;
+    for (size_t b = 0; b < blocks; b++) {
+        CamelliaXor(in, chain, out, BLOCK_128_BIT);
+        cipher.EncryptBlocks(key, out, out, 1);
+        chain = out;
+        in += BLOCK_128_BIT;
+        out += BLOCK_128_BIT;
+    }
+    if (blocks)
+        memcpy(iv, chain, BLOCK_128_BIT);
+}
+
+void CamelliaCBC_DecryptBlocks(const CamelliaKey& key, unsigned char* iv,
+    const unsigned char* in, unsigned char* out, size_t blocks)
+{
+    const Camellia cipher;
+    unsigned char plain[CAMELLIA_CBC_BLOCKS * BLOCK_128_BIT];
+    unsigned char last[BLOCK_128_BIT];
+
+    while (blocks) {
+        size_t n = blocks < CAMELLIA_CBC_BLOCKS ? blocks : CAMELLIA_CBC_BLOCKS;
+        cipher.DecryptBlocks(key, in, plain, n);
+        // Останній шифроблок пакета - ланцюжок для наступного; зберігається
+        // до запису, бо out може збігатися з in
+        memcpy(last, in + (n - 1) * BLOCK_128_BIT, BLOCK_128_BIT);
+        // Від кінця до початку: in[i - 1] ще не перезаписаний, коли пишеться out[i]
+        for (size_t i = n - 1; i > 0; i--)
+            CamelliaXor(plain + i * BLOCK_128_BIT, in + (i - 1) * BLOCK_128_BIT,
+                out + i * BLOCK_128_BIT, BLOCK_128_BIT);
+        CamelliaXor(plain, iv, out, BLOCK_128_BIT);
+        memcpy(iv, last, BLOCK_128_BIT);
+        in += n * BLOCK_128_BIT;
+        out += n * BLOCK_128_BIT;
+        blocks -= n;
+    }
+}
+
+size_t CamelliaCBC_Encrypt(const CamelliaKey& key, const unsigned char* iv,
+    const unsigned char* in, size_t length, unsigned char* out)
+{
+    unsigned char chain[BLOCK_128_BIT];
+    memcpy(chain, iv, BLOCK_128_BIT);
+    size_t blocks = length / BLOCK_128_BIT;
+    CamelliaCBC_EncryptBlocks(key, chain, in, out, blocks);
+
+    size_t rest = length % BLOCK_128_BIT;
+    unsigned char last[BLOCK_128_BIT];
+    memcpy(last, in + blocks * BLOCK_128_BIT, rest);
+    memset(last + rest, (int)(BLOCK_128_BIT - rest), BLOCK_128_BIT - rest);
+    CamelliaCBC_EncryptBlocks(key, chain, last, out + blocks * BLOCK_128_BIT, 1);
+    return (blocks + 1) * BLOCK_128_BIT;
+}
+
+bool CamelliaCBC_Decrypt(const CamelliaKey& key, const unsigned char* iv,
+    const unsigned char* in, size_t length, unsigned char* out, size_t& outLength)
+{
+    outLength = 0;
+    if (length == 0 || length % BLOCK_128_BIT)
+        return false;
+    unsigned char chain[BLOCK_128_BIT];
+    memcpy(chain, iv, BLOCK_128_BIT);
+    CamelliaCBC_DecryptBlocks(key, chain, in, out, length / BLOCK_128_BIT);
+
+    // Маски замість умов: час перевірки не залежить від того, де доповнення зламане
+    const unsigned char* last = out + length - BLOCK_128_BIT;
+    unsigned pad = last[BLOCK_128_BIT - 1];
+    unsigned bad = ((pad - 1) >> 8) | ((BLOCK_128_BIT - pad) >> 8);
+    for (unsigned i = 0; i < BLOCK_128_BIT; i++) {
+        unsigned inPad = (BLOCK_128_BIT - 1 - i - pad) >> 8 & 1;
+        bad |= inPad & (last[i] ^ pad);
+    }
+    if (bad & 0xff)
+        return false;
+    outLength = length - pad;
+    return true;
+}
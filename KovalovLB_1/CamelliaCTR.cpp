@@ -0,0 +1,42 @@
+#include "CamelliaModes.h"
+
+static inline u64 LoadBE64(const unsigned char* p) {
+    return ByteToBit(p);
+}
+
+void CamelliaCTR_Crypt(const CamelliaKey& key, const unsigned char* iv, u64 offset,
+    const unsigned char* in, unsigned char* out, size_t length)
+{
+    const Camellia cipher;
+    unsigned char counters[CAMELLIA_CTR_BLOCKS * BLOCK_128_BIT];
+    unsigned char stream[CAMELLIA_CTR_BLOCKS * BLOCK_128_BIT];
+
+    // Лічильник першого блоку: iv + offset / 16 з перенесенням у старшу половину
+    u64 hi = LoadBE64(iv), lo = LoadBE64(iv + 8);
+    u64 next = lo + offset / BLOCK_128_BIT;
+    hi += next < lo;
+    lo = next;
+    size_t skip = (size_t)(offset % BLOCK_128_BIT);
+
+    while (length) {
+        size_t bytes = skip + length;
+        size_t blocks = (bytes + BLOCK_128_BIT - 1) / BLOCK_128_BIT;
+        if (blocks > CAMELLIA_CTR_BLOCKS)
+            blocks = CAMELLIA_CTR_BLOCKS;
+        for (size_t b = 0; b < blocks; b++) {
+            CamelliaStoreBE64(counters + b * BLOCK_128_BIT, hi);
+            CamelliaStoreBE64(counters + b * BLOCK_128_BIT + 8, lo);
+            hi += ++lo == 0;
+        }
+        cipher.EncryptBlocks(key, counters, stream, blocks);
+
+        size_t used = blocks * BLOCK_128_BIT - skip;
+        if (used > length)
+            used = length;
+        CamelliaXor(in, stream + skip, out, used);
+        in += used;
+        out += used;
+        length -= used;
+        skip = 0;
+    }
+}
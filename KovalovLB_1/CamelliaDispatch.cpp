@@ -0,0 +1,215 @@
+﻿#include "Camellia.h"
+#include <cstdlib>
+#include <cstring>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static void CpuId(int leaf, int subleaf, unsigned int regs[4]) {
+#ifdef _MSC_VER
+    int r[4];
+    __cpuidex(r, leaf, subleaf);
+    for (int i = 0; i < 4; i++)
+        regs[i] = (unsigned int)r[i];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Чи зберігає ОС стан XMM та YMM регістрів (XCR0)
+static bool OsSavesYmm() {
+#ifdef _MSC_VER
+    return (_xgetbv(0) & 6) == 6;
+#else
+    unsigned int lo, hi;
+    __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (lo & 6) == 6;
+#endif
+}
+
+static CamelliaCpuFeatures DetectCpu() {
+    CamelliaCpuFeatures cpu = {};
+    unsigned int r[4];
+    CpuId(0, 0, r);
+    unsigned int maxLeaf = r[0];
+    if (maxLeaf < 1)
+        return cpu;
+
+    CpuId(1, 0, r);
+    cpu.sse2 = (r[3] >> 26) & 1;
+    cpu.ssse3 = (r[2] >> 9) & 1;
+    cpu.pclmul = (r[2] >> 1) & 1;
+    cpu.aesni = (r[2] >> 25) & 1;
+    bool avx = ((r[2] >> 27) & 1) && ((r[2] >> 28) & 1) && OsSavesYmm();
+    if (avx && maxLeaf >= 7) {
+        CpuId(7, 0, r);
+        cpu.avx2 = (r[1] >> 5) & 1;
+    }
+    return cpu;
+}
+
+const CamelliaCpuFeatures& CamelliaCpu() {
+    static const CamelliaCpuFeatures cpu = DetectCpu();
+    return cpu;
+}
+
+static size_t ScalarBatch(const u64*, const u64*, const u64*, int,
+    const unsigned char*, unsigned char*, size_t)
+{
+    return 0;
+}
+
+#if CAMELLIA_AESNI
+static size_t AESNIBatch(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out, size_t blocks)
+{
+    size_t i = 0;
+    for (; i + CAMELLIA_AESNI_BLOCKS <= blocks; i += CAMELLIA_AESNI_BLOCKS)
+        CamelliaAESNI_Crypt16(kw, ke, k, rounds, in + i * BLOCK_128_BIT, out + i * BLOCK_128_BIT);
+    return i;
+}
+static size_t AESNIKeyAB(const unsigned char* kl, const unsigned char* kr,
+    u64* ka, u64* kb, size_t keys)
+{
+    size_t i = 0;
+    for (; i + CAMELLIA_AESNI_BLOCKS <= keys; i += CAMELLIA_AESNI_BLOCKS)
+        CamelliaAESNI_KeyAB16(kl + i * BLOCK_128_BIT, kr + i * BLOCK_128_BIT, ka + 2 * i,
+            kb ? kb + 2 * i : nullptr);
+    return i;
+}
+#endif
+
+#if CAMELLIA_AVX2
+// Залишок менший за 32 блоки добирається 16-блоковим AES-NI ядром
+static size_t AVX2Batch(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out, size_t blocks)
+{
+    size_t i = 0;
+    for (; i + CAMELLIA_AVX2_BLOCKS <= blocks; i += CAMELLIA_AVX2_BLOCKS)
+        CamelliaAVX2_Crypt32(kw, ke, k, rounds, in + i * BLOCK_128_BIT, out + i * BLOCK_128_BIT);
+    for (; i + CAMELLIA_AESNI_BLOCKS <= blocks; i += CAMELLIA_AESNI_BLOCKS)
+        CamelliaAESNI_Crypt16(kw, ke, k, rounds, in + i * BLOCK_128_BIT, out + i * BLOCK_128_BIT);
+    return i;
+}
+static size_t AVX2KeyAB(const unsigned char* kl, const unsigned char* kr,
+    u64* ka, u64* kb, size_t keys)
+{
+    size_t i = 0;
+    for (; i + CAMELLIA_AVX2_BLOCKS <= keys; i += CAMELLIA_AVX2_BLOCKS)
+        CamelliaAVX2_KeyAB32(kl + i * BLOCK_128_BIT, kr + i * BLOCK_128_BIT, ka + 2 * i,
+            kb ? kb + 2 * i : nullptr);
+    for (; i + CAMELLIA_AESNI_BLOCKS <= keys; i += CAMELLIA_AESNI_BLOCKS)
+        CamelliaAESNI_KeyAB16(kl + i * BLOCK_128_BIT, kr + i * BLOCK_128_BIT, ka + 2 * i,
+            kb ? kb + 2 * i : nullptr);
+    return i;
+}
+#endif
+
+#if CAMELLIA_SSSE3
+static size_t SSSE3Batch(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out, size_t blocks)
+{
+    size_t i = 0;
+    for (; i + CAMELLIA_SSSE3_BLOCKS <= blocks; i += CAMELLIA_SSSE3_BLOCKS)
+        CamelliaSSSE3_Crypt16(kw, ke, k, rounds, in + i * BLOCK_128_BIT, out + i * BLOCK_128_BIT);
+    return i;
+}
+#endif
+
+#if CAMELLIA_PORTABLE
+static size_t PortableBatch(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out, size_t blocks)
+{
+    size_t i = 0;
+    for (; i + CAMELLIA_PORTABLE_BLOCKS <= blocks; i += CAMELLIA_PORTABLE_BLOCKS)
+        CamelliaPortable_Crypt(kw, ke, k, rounds, in + i * BLOCK_128_BIT, out + i * BLOCK_128_BIT);
+    return i;
+}
+#endif
+
+#if CAMELLIA_BITSLICE
+// Залишок повних блоків доповнюється до 64, тому табличний шлях не виконується
+static size_t BitsliceBatch(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out, size_t blocks)
+{
+    size_t i = 0;
+    for (; i + CAMELLIA_BITSLICE_BLOCKS <= blocks; i += CAMELLIA_BITSLICE_BLOCKS)
+        CamelliaBitslice_Crypt128(kw, ke, k, rounds, in + i * BLOCK_128_BIT, out + i * BLOCK_128_BIT);
+    for (; i < blocks; i += CAMELLIA_BITSLICE_TAIL_BLOCKS) {
+        unsigned char tail[CAMELLIA_BITSLICE_TAIL_BLOCKS * BLOCK_128_BIT] = {};
+        size_t n = blocks - i < CAMELLIA_BITSLICE_TAIL_BLOCKS ? blocks - i : CAMELLIA_BITSLICE_TAIL_BLOCKS;
+        memcpy(tail, in + i * BLOCK_128_BIT, n * BLOCK_128_BIT);
+        CamelliaBitslice_Crypt64(kw, ke, k, rounds, tail, tail);
+        memcpy(out + i * BLOCK_128_BIT, tail, n * BLOCK_128_BIT);
+        if (n < CAMELLIA_BITSLICE_TAIL_BLOCKS)
+            return blocks;
+    }
+    return i;
+}
+#endif
+
+static bool Supported(const char* name) {
+    const CamelliaCpuFeatures& cpu = CamelliaCpu();
+    if (!strcmp(name, "avx2"))
+        return cpu.avx2 && cpu.aesni;
+    if (!strcmp(name, "aesni"))
+        return cpu.aesni && cpu.ssse3;
+    if (!strcmp(name, "ssse3"))
+        return cpu.ssse3;
+    if (!strcmp(name, "bitslice"))
+        return cpu.sse2;
+    return true;
+}
+
+// Від найшвидшого до найповільнішого. Після scalar - лише на вимогу: переносний
+// бекенд без AVX2 не швидший за чотириблокове скалярне ядро, а бітсліс
+// лише на рівні скалярного і повільніший за SIMD-ядра, зате не залежить
+// від даних за часом виконання
+static const CamelliaBackend BACKENDS[] = {
+#if CAMELLIA_AVX2
+    { "avx2", AVX2Batch, AVX2KeyAB },
+#endif
+#if CAMELLIA_AESNI
+    { "aesni", AESNIBatch, AESNIKeyAB },
+#endif
+#if CAMELLIA_SSSE3
+    { "ssse3", SSSE3Batch, nullptr },
+#endif
+    { "scalar", ScalarBatch, nullptr },
+#if CAMELLIA_PORTABLE
+    { "portable", PortableBatch, nullptr },
+#endif
+#if CAMELLIA_BITSLICE
+    { "bitslice", BitsliceBatch, nullptr },
+#endif
+};
+static const size_t BACKENDS_COUNT = sizeof(BACKENDS) / sizeof(BACKENDS[0]);
+
+static const CamelliaBackend* SelectBackend() {
+#if CAMELLIA_CONSTANT_TIME
+    // Лише бітсліс; без SSE2 лишається скалярний шлях зі SBOX1 сталого часу
+    for (size_t i = 0; i < BACKENDS_COUNT; i++)
+        if (!strcmp(BACKENDS[i].name, "bitslice") && Supported(BACKENDS[i].name))
+            return &BACKENDS[i];
+    for (size_t i = 0; i < BACKENDS_COUNT; i++)
+        if (!strcmp(BACKENDS[i].name, "scalar"))
+            return &BACKENDS[i];
+#endif
+    // Недоступний на цьому процесорі бекенд ігнорується
+    const char* pinned = getenv("CAMELLIA_BACKEND");
+    if (pinned)
+        for (size_t i = 0; i < BACKENDS_COUNT; i++)
+            if (!strcmp(pinned, BACKENDS[i].name) && Supported(BACKENDS[i].name))
+                return &BACKENDS[i];
+    for (size_t i = 0; i < BACKENDS_COUNT; i++)
+        if (Supported(BACKENDS[i].name))
+            return &BACKENDS[i];
+    return &BACKENDS[0];
+}
+
+const CamelliaBackend& CamelliaSelectedBackend() {
+    static const CamelliaBackend* backend = SelectBackend();
+    return *backend;
+}
@@ -0,0 +1,253 @@
+#include "CamelliaModes.h"
+#if CAMELLIA_GCM_PCLMUL
+#include <immintrin.h>
+#endif
+
+// Множення в GF(2^128) за алгоритмом 1 SP 800-38D маскою замість умов,
+// щоб час не залежав від даних
+static void GfMul(u64& xHi, u64& xLo, u64 hHi, u64 hLo) {
+    u64 zHi = 0, zLo = 0, vHi = hHi, vLo = hLo;
+    for (int i = 0; i < 128; i++) {
+        u64 bit = i < 64 ? xHi >> (63 - i) : xLo >> (127 - i);
+        u64 mask = 0 - (bit & 1);
+        zHi ^= vHi & mask;
+        zLo ^= vLo & mask;
+        u64 carry = 0 - (vLo & 1);
+        vLo = (vLo >> 1) | (vHi << 63);
+        vHi = (vHi >> 1) ^ (0xe100000000000000 & carry);
+    }
+    xHi = zHi;
+    xLo = zLo;
+}
+
+static void GhashPortable(unsigned char* state, const unsigned char* data, size_t blocks, u64 hHi, u64 hLo) {
+    u64 xHi = ByteToBit(state), xLo = ByteToBit((state + 8));
+    for (size_t b = 0; b < blocks; b++, data += BLOCK_128_BIT) {
+        xHi ^= ByteToBit(data);
+        xLo ^= ByteToBit((data + 8));
+        GfMul(xHi, xLo, hHi, hLo);
+    }
+    CamelliaStoreBE64(state, xHi);
+    CamelliaStoreBE64(state + 8, xLo);
+}
+
+#if CAMELLIA_GCM_PCLMUL
+// Блоки GHASH обертаються як 128-бітні числа, після чого множення - це
+// CLMUL з лівим зсувом на 1 і редукцією за x^128 + x^7 + x^2 + x + 1
+// (Gueron, Kounavis, "Intel Carry-Less Multiplication Instruction and its Usage for Computing the GCM Mode")
+static inline __m128i Bswap(__m128i x) {
+    return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// lo/mid/hi накопичують неповний 256-бітний добуток без редукції
+static inline void ClmulAccumulate(__m128i a, __m128i b, __m128i& lo, __m128i& mid, __m128i& hi) {
+    lo = _mm_xor_si128(lo, _mm_clmulepi64_si128(a, b, 0x00));
+    hi = _mm_xor_si128(hi, _mm_clmulepi64_si128(a, b, 0x11));
+    mid = _mm_xor_si128(mid, _mm_clmulepi64_si128(a, b, 0x10));
+    mid = _mm_xor_si128(mid, _mm_clmulepi64_si128(a, b, 0x01));
+}
+
+static inline __m128i Reduce(__m128i lo, __m128i mid, __m128i hi) {
+    lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+    // Зсув 256-бітного добутку на 1 вліво через обернений порядок бітів
+    __m128i carryLo = _mm_srli_epi32(lo, 31);
+    __m128i carryHi = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    __m128i cross = _mm_srli_si128(carryLo, 12);
+    carryHi = _mm_slli_si128(carryHi, 4);
+    carryLo = _mm_slli_si128(carryLo, 4);
+    lo = _mm_or_si128(lo, carryLo);
+    hi = _mm_or_si128(hi, carryHi);
+    hi = _mm_or_si128(hi, cross);
+
+    __m128i a = _mm_slli_epi32(lo, 31);
+    __m128i b = _mm_slli_epi32(lo, 30);
+    __m128i c = _mm_slli_epi32(lo, 25);
+    a = _mm_xor_si128(_mm_xor_si128(a, b), c);
+    __m128i rest = _mm_srli_si128(a, 4);
+    a = _mm_slli_si128(a, 12);
+    lo = _mm_xor_si128(lo, a);
+
+    __m128i d = _mm_srli_epi32(lo, 1);
+    __m128i e = _mm_srli_epi32(lo, 2);
+    __m128i f = _mm_srli_epi32(lo, 7);
+    d = _mm_xor_si128(_mm_xor_si128(d, e), _mm_xor_si128(f, rest));
+    lo = _mm_xor_si128(lo, d);
+    return _mm_xor_si128(hi, lo);
+}
+
+static inline __m128i GfMulClmul(__m128i a, __m128i b) {
+    __m128i lo = _mm_setzero_si128(), mid = lo, hi = lo;
+    ClmulAccumulate(a, b, lo, mid, hi);
+    return Reduce(lo, mid, hi);
+}
+
+// Агрегована редукція: X = (X + D1)*H^n + D2*H^(n-1) + ... + Dn*H, одна редукція на n <= 8 блоків
+static void GhashClmul(unsigned char* state, const unsigned char* data, size_t blocks,
+    const unsigned char (*hPowers)[BLOCK_128_BIT])
+{
+    __m128i x = Bswap(_mm_loadu_si128((const __m128i*)state));
+    while (blocks) {
+        size_t n = blocks < CAMELLIA_GCM_AGGREGATE ? blocks : CAMELLIA_GCM_AGGREGATE;
+        __m128i lo = _mm_setzero_si128(), mid = lo, hi = lo;
+        for (size_t i = 0; i < n; i++) {
+            __m128i d = Bswap(_mm_loadu_si128((const __m128i*)(data + i * BLOCK_128_BIT)));
+            if (i == 0)
+                d = _mm_xor_si128(d, x);
+            ClmulAccumulate(d, _mm_load_si128((const __m128i*)hPowers[n - 1 - i]), lo, mid, hi);
+        }
+        x = Reduce(lo, mid, hi);
+        data += n * BLOCK_128_BIT;
+        blocks -= n;
+    }
+    _mm_storeu_si128((__m128i*)state, Bswap(x));
+}
+#endif
+
+CamelliaGCM::CamelliaGCM(const CamelliaKey& key) : key(key)
+{
+    unsigned char h[BLOCK_128_BIT] = {};
+    const Camellia cipher;
+    cipher.EncryptBlocks(key, h, h, 1);
+    hHi = ByteToBit(h);
+    hLo = ByteToBit((h + 8));
+    memset(hPowers, 0, sizeof(hPowers));
+#if CAMELLIA_GCM_PCLMUL
+    pclmul = CamelliaCpu().pclmul && CamelliaCpu().ssse3;
+    if (pclmul) {
+        __m128i h1 = Bswap(_mm_loadu_si128((const __m128i*)h));
+        __m128i power = h1;
+        _mm_store_si128((__m128i*)hPowers[0], power);
+        for (int i = 1; i < CAMELLIA_GCM_AGGREGATE; i++) {
+            power = GfMulClmul(power, h1);
+            _mm_store_si128((__m128i*)hPowers[i], power);
+        }
+    }
+#else
+    pclmul = false;
+#endif
+}
+
+// Повні блоки, потім залишок, доповнений нулями
+void CamelliaGCM::Ghash(unsigned char* state, const unsigned char* data, size_t length) const {
+    // Порожні AAD чи текст можуть прийти як nullptr
+    if (length == 0)
+        return;
+    size_t blocks = length / BLOCK_128_BIT;
+    unsigned char last[BLOCK_128_BIT] = {};
+    size_t rest = length % BLOCK_128_BIT;
+    memcpy(last, data + blocks * BLOCK_128_BIT, rest);
+#if CAMELLIA_GCM_PCLMUL
+    if (pclmul) {
+        GhashClmul(state, data, blocks, hPowers);
+        if (rest)
+            GhashClmul(state, last, 1, hPowers);
+        return;
+    }
+#endif
+    GhashPortable(state, data, blocks, hHi, hLo);
+    if (rest)
+        GhashPortable(state, last, 1, hHi, hLo);
+}
+
+// J0 = IV || 0^31 || 1 для 96-бітного IV, інакше GHASH(IV || 0 || [len(IV)]64)
+void CamelliaGCM::CounterZero(const unsigned char* iv, size_t ivLength, unsigned char* j0) const {
+    if (ivLength == 12) {
+        memcpy(j0, iv, 12);
+        j0[12] = j0[13] = j0[14] = 0;
+        j0[15] = 1;
+        return;
+    }
+    memset(j0, 0, BLOCK_128_BIT);
+    Ghash(j0, iv, ivLength);
+    unsigned char lengths[BLOCK_128_BIT] = {};
+    CamelliaStoreBE64(lengths + 8, (u64)ivLength * 8);
+    Ghash(j0, lengths, BLOCK_128_BIT);
+}
+
+// CTR з інкрементом молодших 32 бітів від J0 + 1 пакетами по CAMELLIA_CTR_BLOCKS;
+// GHASH кожного пакета шифротексту йде одразу за його шифруванням
+// (при розшифруванні - перед ним, тож in == out безпечне)
+void CamelliaGCM::Crypt(const unsigned char* j0, const unsigned char* in, unsigned char* out, size_t length,
+    unsigned char* state, bool decrypt) const
+{
+    const Camellia cipher;
+    unsigned char counters[CAMELLIA_CTR_BLOCKS * BLOCK_128_BIT];
+    unsigned char stream[CAMELLIA_CTR_BLOCKS * BLOCK_128_BIT];
+    u32 counter = (u32)ByteToBit((j0 + 8));
+
+    while (length) {
+        size_t bytes = length < sizeof(stream) ? length : sizeof(stream);
+        size_t blocks = (bytes + BLOCK_128_BIT - 1) / BLOCK_128_BIT;
+        for (size_t b = 0; b < blocks; b++) {
+            unsigned char* block = counters + b * BLOCK_128_BIT;
+            memcpy(block, j0, 12);
+            counter++;
+            for (int i = 0; i < 4; i++)
+                block[12 + i] = (unsigned char)(counter >> (24 - 8 * i));
+        }
+        cipher.EncryptBlocks(key, counters, stream, blocks);
+
+        if (decrypt)
+            Ghash(state, in, bytes);
+        CamelliaXor(in, stream, out, bytes);
+        if (!decrypt)
+            Ghash(state, out, bytes);
+        in += bytes;
+        out += bytes;
+        length -= bytes;
+    }
+}
+
+// Тег = E(J0) ^ GHASH(... || [len(A)]64 || [len(C)]64)
+void CamelliaGCM::Finish(const unsigned char* j0, unsigned char* state, size_t aadLength, size_t length) const {
+    unsigned char lengths[BLOCK_128_BIT];
+    CamelliaStoreBE64(lengths, (u64)aadLength * 8);
+    CamelliaStoreBE64(lengths + 8, (u64)length * 8);
+    Ghash(state, lengths, BLOCK_128_BIT);
+    unsigned char mask[BLOCK_128_BIT];
+    const Camellia cipher;
+    cipher.EncryptBlocks(key, j0, mask, 1);
+    CamelliaXor(state, mask, state, BLOCK_128_BIT);
+}
+
+bool CamelliaGCM::Encrypt(const unsigned char* iv, size_t ivLength, const unsigned char* aad, size_t aadLength,
+    const unsigned char* in, size_t length, unsigned char* out, unsigned char* tag) const
+{
+    if ((u64)length > CAMELLIA_GCM_MAX_LENGTH || (u64)aadLength >> 61 || ivLength == 0)
+        return false;
+    unsigned char j0[BLOCK_128_BIT], state[BLOCK_128_BIT] = {};
+    CounterZero(iv, ivLength, j0);
+    Ghash(state, aad, aadLength);
+    Crypt(j0, in, out, length, state, false);
+    Finish(j0, state, aadLength, length);
+    memcpy(tag, state, CAMELLIA_GCM_TAG);
+    return true;
+}
+
+bool CamelliaGCM::Decrypt(const unsigned char* iv, size_t ivLength, const unsigned char* aad, size_t aadLength,
+    const unsigned char* in, size_t length, const unsigned char* tag, size_t tagLength,
+    unsigned char* out) const
+{
+    if ((u64)length > CAMELLIA_GCM_MAX_LENGTH || (u64)aadLength >> 61 || ivLength == 0 ||
+        tagLength < CAMELLIA_GCM_MIN_TAG || tagLength > CAMELLIA_GCM_TAG)
+        return false;
+    unsigned char j0[BLOCK_128_BIT], state[BLOCK_128_BIT] = {};
+    CounterZero(iv, ivLength, j0);
+    Ghash(state, aad, aadLength);
+    Crypt(j0, in, out, length, state, true);
+    Finish(j0, state, aadLength, length);
+
+    // Порівняння без раннього виходу
+    unsigned char diff = 0;
+    for (size_t i = 0; i < tagLength; i++)
+        diff |= state[i] ^ tag[i];
+    if (diff) {
+        memset(out, 0, length);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,101 @@
+#include "CamelliaKeyCache.h"
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+CamelliaKeyCache::CamelliaKeyCache(size_t capacity)
+{
+    setCount = 1;
+    while (setCount * CAMELLIA_CACHE_WAYS < capacity)
+        setCount <<= 1;
+    sets.reset(new Set[setCount]);
+    // Випадкова сіль не дає підібрати ключі, що витісняють один одного
+    std::random_device random;
+    seed = ((u64)random() << 32) | random();
+}
+
+// Сіль, ключ по 8 байтів та довжина перемішуються множенням і фіналізатором
+// splitmix64: дайджест лише обирає набір і відсіює чужі слоти, а збіг
+// підтверджується повним порівнянням ключа
+static inline u64 Mix(u64 h) {
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+    return h ^ (h >> 31);
+}
+u64 CamelliaKeyCache::Digest(const unsigned char* key, size_t length) const {
+    u64 h = seed ^ length;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        u64 word;
+        memcpy(&word, key + i, 8);
+        h = Mix(h ^ word);
+    }
+    for (; i < length; i++)
+        h = Mix(h ^ key[i]);
+    return h;
+}
+
+bool CamelliaKeyCache::Lookup(Set& set, u64 digest, const unsigned char* key, size_t length, CamelliaKey& out) {
+    for (int w = 0; w < CAMELLIA_CACHE_WAYS; w++) {
+        Slot& slot = set.ways[w];
+        u32 version = slot.version.load(std::memory_order_acquire);
+        if ((version & 1) || slot.digest.load(std::memory_order_relaxed) != digest)
+            continue;
+        if (slot.length != length || memcmp(slot.raw, key, length))
+            continue;
+        memcpy(&out, &slot.key, sizeof(CamelliaKey));
+        // Запис, що почався під час копіювання, змінить версію
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) != version)
+            continue;
+        if (!slot.referenced.load(std::memory_order_relaxed))
+            slot.referenced.store(true, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void CamelliaKeyCache::Insert(Set& set, u64 digest, const unsigned char* key, size_t length,
+    const CamelliaKey& expanded)
+{
+    // Зайнятий набір інший потік саме оновлює; ключ просто не кешується
+    if (set.writer.test_and_set(std::memory_order_acquire))
+        return;
+    // CLOCK: слот з ненульовим бітом звертання отримує ще один шанс
+    Slot* victim;
+    for (;;) {
+        victim = &set.ways[set.hand];
+        set.hand = (set.hand + 1) % CAMELLIA_CACHE_WAYS;
+        if (!victim->referenced.exchange(false, std::memory_order_relaxed))
+            break;
+    }
+    if (victim->length)
+        evictions.fetch_add(1, std::memory_order_relaxed);
+
+    u32 version = victim->version.load(std::memory_order_relaxed);
+    victim->version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    victim->digest.store(digest, std::memory_order_relaxed);
+    memcpy(victim->raw, key, length);
+    victim->length = length;
+    memcpy(&victim->key, &expanded, sizeof(CamelliaKey));
+    victim->version.store(version + 2, std::memory_order_release);
+
+    set.writer.clear(std::memory_order_release);
+}
+
+CamelliaKey CamelliaKeyCache::Get(const unsigned char* key, size_t length) {
+    if (!CamelliaKey::ValidLength(length))
+        throw std::invalid_argument("Camellia key must be 16, 24 or 32 bytes");
+    u64 digest = Digest(key, length);
+    Set& set = sets[digest & (setCount - 1)];
+    CamelliaKey result;
+    if (Lookup(set, digest, key, length, result)) {
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return result;
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+    result = CamelliaKey(key, length);
+    Insert(set, digest, key, length, result);
+    return result;
+}
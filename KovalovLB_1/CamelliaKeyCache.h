@@ -0,0 +1,48 @@
+#pragma once
+#include "Camellia.h"
+#include <atomic>
+#include <memory>
+
+// Асоціативність кешу: кількість слотів у наборі, серед яких шукається ключ
+#define CAMELLIA_CACHE_WAYS 4
+
+// Спільний для потоків кеш розгорнутих ключів з обмеженою пам'яттю.
+// Набір обирається за дайджестом ключа; пошук не блокується (seqlock на слот),
+// вставка захоплює лише свій набір, а витіснення - CLOCK у межах набору
+class CamelliaKeyCache {
+public:
+    // Місткість у ключах округлюється вгору до степеня двійки, не менше CAMELLIA_CACHE_WAYS
+    explicit CamelliaKeyCache(size_t capacity);
+    // Розгорнутий ключ з кешу, або щойно розгорнутий і доданий до кешу;
+    // std::invalid_argument, якщо length не 16, 24 чи 32
+    CamelliaKey Get(const unsigned char* key, size_t length);
+
+    u64 Hits() const { return hits.load(std::memory_order_relaxed); }
+    u64 Misses() const { return misses.load(std::memory_order_relaxed); }
+    u64 Evictions() const { return evictions.load(std::memory_order_relaxed); }
+    size_t Capacity() const { return setCount * CAMELLIA_CACHE_WAYS; }
+private:
+    struct alignas(64) Slot {
+        // Непарна версія - слот саме перезаписується
+        std::atomic<u32> version{ 0 };
+        std::atomic<bool> referenced{ false };
+        std::atomic<u64> digest{ 0 };
+        unsigned char raw[KEY_256_BIT] = {};
+        size_t length = 0;
+        CamelliaKey key;
+    };
+    struct alignas(64) Set {
+        Slot ways[CAMELLIA_CACHE_WAYS];
+        std::atomic_flag writer = ATOMIC_FLAG_INIT;
+        unsigned hand = 0;
+    };
+
+    u64 Digest(const unsigned char* key, size_t length) const;
+    bool Lookup(Set& set, u64 digest, const unsigned char* key, size_t length, CamelliaKey& out);
+    void Insert(Set& set, u64 digest, const unsigned char* key, size_t length, const CamelliaKey& expanded);
+
+    std::unique_ptr<Set[]> sets;
+    size_t setCount;
+    u64 seed;
+    std::atomic<u64> hits{ 0 }, misses{ 0 }, evictions{ 0 };
+};
@@ -0,0 +1,208 @@
+#include "CamelliaKeyStore.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef _MSC_VER
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char STORE_MAGIC[8] = { 'C', 'A', 'M', 'K', 'E', 'Y', 'S', 0 };
+// Записаний у рідному порядку байтів: на машині з іншим порядком не збігається
+static const u32 STORE_BYTE_ORDER = 0x01020304;
+
+// Перемішування splitmix64 по 8-байтних словах; захищає від пошкоджених
+// та застарілих даних, але не від навмисної підробки файлу
+u64 CamelliaKeyStore::Checksum(const void* data, size_t length, u64 seed) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    u64 h = seed ^ length;
+    for (size_t i = 0; i < length; i += 8) {
+        u64 word = 0;
+        memcpy(&word, bytes + i, length - i < 8 ? length - i : 8);
+        h ^= word;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+u64 CamelliaKeyStore::HeaderChecksum(const Header& header) {
+    return Checksum(&header, offsetof(Header, checksum), CAMELLIA_KEY_STORE_VERSION);
+}
+
+// Лише поля розкладу на їхніх місцях у CamelliaKey; вирівнювальні байти
+// об'єкта лишаються нульовими, а не тим, що було в пам'яті
+void CamelliaKeyStore::StoreKey(const CamelliaKey& key, unsigned char* out) {
+    memcpy(out + offsetof(CamelliaKey, kw), key.kw, sizeof(key.kw));
+    memcpy(out + offsetof(CamelliaKey, ke), key.ke, sizeof(key.ke));
+    memcpy(out + offsetof(CamelliaKey, k), key.k, sizeof(key.k));
+    memcpy(out + offsetof(CamelliaKey, dkw), key.dkw, sizeof(key.dkw));
+    memcpy(out + offsetof(CamelliaKey, dke), key.dke, sizeof(key.dke));
+    memcpy(out + offsetof(CamelliaKey, dk), key.dk, sizeof(key.dk));
+    memcpy(out + offsetof(CamelliaKey, rounds), &key.rounds, sizeof(key.rounds));
+}
+
+// Файл пишеться поруч як path.tmp, скидається на диск і лише тоді атомарно
+// заміщує path: читачі бачать або старий файл, або новий, але не обрізаний
+bool CamelliaKeyStore::Write(const char* path, const u64* ids, const CamelliaKey* keys, size_t count) {
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [ids](size_t a, size_t b) { return ids[a] < ids[b]; });
+    // З однаковими ідентифікаторами Find повертав би будь-який із записів
+    for (size_t i = 1; i < count; i++)
+        if (ids[order[i - 1]] == ids[order[i]])
+            return false;
+
+    std::string temp = std::string(path) + ".tmp";
+    FILE* out = fopen(temp.c_str(), "wb");
+    if (!out)
+        return false;
+    unsigned char headerBytes[HEADER_SIZE] = {};
+    Header header = {};
+    memcpy(header.magic, STORE_MAGIC, sizeof(header.magic));
+    header.version = CAMELLIA_KEY_STORE_VERSION;
+    header.byteOrder = STORE_BYTE_ORDER;
+    header.keySize = sizeof(CamelliaKey);
+    header.recordSize = sizeof(Record);
+    header.count = count;
+    header.checksum = HeaderChecksum(header);
+    memcpy(headerBytes, &header, sizeof(header));
+    bool ok = fwrite(headerBytes, HEADER_SIZE, 1, out) == 1;
+
+    for (size_t i = 0; i < count && ok; i++) {
+        Record record;
+        memset(&record, 0, sizeof(record));
+        record.id = ids[order[i]];
+        StoreKey(keys[order[i]], record.key);
+        record.checksum = Checksum(record.key, sizeof(record.key), record.id);
+        ok = fwrite(&record, sizeof(record), 1, out) == 1;
+    }
+    ok = ok && fflush(out) == 0;
+#ifdef _MSC_VER
+    ok = ok && _commit(_fileno(out)) == 0;
+#else
+    ok = ok && fsync(fileno(out)) == 0;
+#endif
+    ok = (fclose(out) == 0) && ok;
+#ifdef _MSC_VER
+    ok = ok && MoveFileExA(temp.c_str(), path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    ok = ok && rename(temp.c_str(), path) == 0;
+#endif
+    if (!ok) {
+        remove(temp.c_str());
+        return false;
+    }
+#ifndef _MSC_VER
+    // Перейменування стає стійким до збою лише після fsync каталогу
+    // (у Windows це робить MOVEFILE_WRITE_THROUGH)
+    std::string dir(path);
+    size_t slash = dir.find_last_of('/');
+    dir = slash == std::string::npos ? "." : slash == 0 ? "/" : dir.substr(0, slash);
+    int fd = open(dir.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    ok = fsync(fd) == 0;
+    close(fd);
+#endif
+    return ok;
+}
+
+bool CamelliaKeyStore::Open(const char* path) {
+    Close();
+#ifdef _MSC_VER
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+    file = handle;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart < (LONGLONG)HEADER_SIZE) {
+        Close();
+        return false;
+    }
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        Close();
+        return false;
+    }
+    view = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    viewSize = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)HEADER_SIZE) {
+        close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map != MAP_FAILED) {
+        view = (const unsigned char*)map;
+        viewSize = (size_t)st.st_size;
+    }
+#endif
+    if (!view) {
+        Close();
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, view, sizeof(header));
+    if (memcmp(header.magic, STORE_MAGIC, sizeof(header.magic)) || header.version != CAMELLIA_KEY_STORE_VERSION ||
+        header.byteOrder != STORE_BYTE_ORDER || header.keySize != sizeof(CamelliaKey) ||
+        header.recordSize != sizeof(Record) || header.checksum != HeaderChecksum(header) ||
+        (viewSize - HEADER_SIZE) / sizeof(Record) != header.count || (viewSize - HEADER_SIZE) % sizeof(Record))
+    {
+        Close();
+        return false;
+    }
+    records = (const Record*)(view + HEADER_SIZE);
+    count = (size_t)header.count;
+    return true;
+}
+
+void CamelliaKeyStore::Close() {
+#ifdef _MSC_VER
+    if (view)
+        UnmapViewOfFile(view);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file)
+        CloseHandle(file);
+    mapping = file = nullptr;
+#else
+    if (view)
+        munmap((void*)view, viewSize);
+#endif
+    view = nullptr;
+    viewSize = 0;
+    records = nullptr;
+    count = 0;
+}
+
+CamelliaKeyStore::~CamelliaKeyStore() {
+    Close();
+}
+
+const CamelliaKey* CamelliaKeyStore::Find(u64 id) const {
+    const Record* end = records + count;
+    const Record* record = std::lower_bound(records, end, id,
+        [](const Record& r, u64 value) { return r.id < value; });
+    if (record == end || record->id != id ||
+        record->checksum != Checksum(record->key, sizeof(record->key), record->id))
+        return nullptr;
+    return (const CamelliaKey*)record->key;
+}
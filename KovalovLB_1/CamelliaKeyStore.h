@@ -0,0 +1,57 @@
+#pragma once
+#include "Camellia.h"
+
+// Версія формату файлу; файл іншої версії або з іншим розміщенням CamelliaKey відкидається
+#define CAMELLIA_KEY_STORE_VERSION 1
+
+// Файл розгорнутих ключів, що відображається в пам'ять лише для читання і
+// може спільно використовуватися процесами. Після заголовка йдуть записи,
+// відсортовані за ідентифікатором; контрольна сума запису перевіряється
+// під час звернення до нього, тож відкриття не читає весь файл
+class CamelliaKeyStore {
+public:
+    CamelliaKeyStore() {}
+    ~CamelliaKeyStore();
+    CamelliaKeyStore(const CamelliaKeyStore&) = delete;
+    CamelliaKeyStore& operator=(const CamelliaKeyStore&) = delete;
+
+    // Записує keys[i] під ідентифікатором ids[i]; false без запису, якщо ідентифікатори
+    // повторюються. Наявний файл замінюється атомарно через path.tmp і каталог
+    // скидається на диск; false до заміни - path не змінено
+    static bool Write(const char* path, const u64* ids, const CamelliaKey* keys, size_t count);
+    // false, якщо файл не відкривається, має іншу версію, розмір чи пошкоджений заголовок
+    bool Open(const char* path);
+    void Close();
+    // Ключ прямо у відображеній пам'яті; nullptr, якщо ідентифікатора немає
+    // або контрольна сума запису не збігається
+    const CamelliaKey* Find(u64 id) const;
+    size_t Count() const { return count; }
+private:
+    struct Header {
+        char magic[8];
+        u32 version, byteOrder;
+        u32 keySize, recordSize;
+        u64 count;
+        u64 checksum;
+    };
+    struct alignas(64) Record {
+        u64 id;
+        u64 checksum;
+        alignas(64) unsigned char key[sizeof(CamelliaKey)];
+    };
+    static const size_t HEADER_SIZE = 64;
+    static_assert(sizeof(Header) <= HEADER_SIZE, "header must fit HEADER_SIZE");
+
+    static void StoreKey(const CamelliaKey& key, unsigned char* out);
+    static u64 Checksum(const void* data, size_t length, u64 seed);
+    static u64 HeaderChecksum(const Header& header);
+
+    const unsigned char* view = nullptr;
+    size_t viewSize = 0;
+    const Record* records = nullptr;
+    size_t count = 0;
+#ifdef _MSC_VER
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
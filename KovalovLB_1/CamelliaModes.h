@@ -0,0 +1,160 @@
+#pragma once
+#include "Camellia.h"
+#include <cstring>
+
+// Скільки блоків ключового потоку CTR готується за раз: пакет іде одним
+// викликом у ядро вибраного бекенду (32/16 блоків), а залишок - у 4/2/1-блокові
+#define CAMELLIA_CTR_BLOCKS 32
+
+// out = a ^ b по 8 байтів; out може збігатися з a чи b
+inline void CamelliaXor(const unsigned char* a, const unsigned char* b, unsigned char* out, size_t length) {
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        u64 x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        x ^= y;
+        memcpy(out + i, &x, 8);
+    }
+    for (; i < length; i++)
+        out[i] = a[i] ^ b[i];
+}
+
+// 64-бітне число у 8 байтів big-endian
+inline void CamelliaStoreBE64(unsigned char* p, u64 x) {
+    for (int i = 0; i < 8; i++)
+        p[i] = (unsigned char)(x >> (56 - 8 * i));
+}
+
+// CTR: лічильник - 128-бітне big-endian число iv + номер блоку.
+// offset - зсув у байтах від початку потоку, тож можна почати з будь-якого місця;
+// довжина довільна, in та out можуть збігатися. Шифрування й розшифрування однакові
+void CamelliaCTR_Crypt(const CamelliaKey& key, const unsigned char* iv, u64 offset,
+    const unsigned char* in, unsigned char* out, size_t length);
+
+// Скільки блоків CBC розшифровується одним викликом ядра
+#define CAMELLIA_CBC_BLOCKS 32
+
+// CBC без доповнення: blocks повних блоків, iv після виклику містить останній
+// блок шифротексту для продовження ланцюжка. Шифрування послідовне за природою
+// режиму, розшифрування йде пакетами через багатоблокові ядра. out може збігатися з in
+void CamelliaCBC_EncryptBlocks(const CamelliaKey& key, unsigned char* iv,
+    const unsigned char* in, unsigned char* out, size_t blocks);
+void CamelliaCBC_DecryptBlocks(const CamelliaKey& key, unsigned char* iv,
+    const unsigned char* in, unsigned char* out, size_t blocks);
+
+// CBC з доповненням PKCS#7: у out має бути місце на length / 16 * 16 + 16 байтів;
+// повертає довжину шифротексту
+size_t CamelliaCBC_Encrypt(const CamelliaKey& key, const unsigned char* iv,
+    const unsigned char* in, size_t length, unsigned char* out);
+// У out має бути місце на length байтів; false, якщо довжина не кратна блоку
+// або доповнення некоректне. Доповнення перевіряється без розгалужень за його вмістом
+bool CamelliaCBC_Decrypt(const CamelliaKey& key, const unsigned char* iv,
+    const unsigned char* in, size_t length, unsigned char* out, size_t& outLength);
+
+// GHASH через PCLMULQDQ, якщо процесор його має; інакше побітове множення в GF(2^128)
+#define CAMELLIA_GCM_PCLMUL 1
+// Скільки блоків GHASH множаться на степені H з однією спільною редукцією
+#define CAMELLIA_GCM_AGGREGATE 8
+#define CAMELLIA_GCM_TAG 16
+// Найкоротший тег, що приймає Decrypt (SP 800-38D, 5.2.1.2: 128, 120, 112, 104, 96 бітів);
+// 64- та 32-бітні теги навмисно не підтримуються
+#define CAMELLIA_GCM_MIN_TAG 12
+// Найбільший відкритий текст GCM: 2^32 - 2 блоки
+#define CAMELLIA_GCM_MAX_LENGTH ((u64)0xfffffffe * BLOCK_128_BIT)
+
+// Camellia-GCM (RFC 6367, NIST SP 800-38D). Об'єкт незмінний після створення,
+// тож один екземпляр можна ділити між потоками. Лічильник і GHASH
+// проходять дані за один прохід: кожен пакет ключового потоку хешується,
+// поки ще лежить у L1. out може збігатися з in
+class CamelliaGCM {
+public:
+    explicit CamelliaGCM(const CamelliaKey& key);
+    // false, якщо length або aadLength перевищують межі GCM
+    bool Encrypt(const unsigned char* iv, size_t ivLength, const unsigned char* aad, size_t aadLength,
+        const unsigned char* in, size_t length, unsigned char* out, unsigned char* tag) const;
+    // Перевіряються перші tagLength байтів обчисленого тегу. false, якщо tagLength
+    // поза 12..16 (out не змінюється) або тег не збігся (out заповнюється нулями)
+    bool Decrypt(const unsigned char* iv, size_t ivLength, const unsigned char* aad, size_t aadLength,
+        const unsigned char* in, size_t length, const unsigned char* tag, size_t tagLength,
+        unsigned char* out) const;
+private:
+    void Ghash(unsigned char* state, const unsigned char* data, size_t length) const;
+    void CounterZero(const unsigned char* iv, size_t ivLength, unsigned char* j0) const;
+    void Crypt(const unsigned char* j0, const unsigned char* in, unsigned char* out, size_t length,
+        unsigned char* state, bool decrypt) const;
+    void Finish(const unsigned char* j0, unsigned char* state, size_t aadLength, size_t length) const;
+
+    CamelliaKey key;
+    // H як 128-бітне big-endian число, і H^1..H^8 у розвернутому порядку байтів для PCLMULQDQ
+    u64 hHi, hLo;
+    alignas(16) unsigned char hPowers[CAMELLIA_GCM_AGGREGATE][BLOCK_128_BIT];
+    bool pclmul;
+};
+
+// Скільки блоків OCB іде одним викликом ядра; зсуви пакета рахуються наперед
+#define CAMELLIA_OCB_BLOCKS 32
+#define CAMELLIA_OCB_TAG 16
+// L_i для i = 0..63 покривають ntz будь-якого 64-бітного номера блоку
+#define CAMELLIA_OCB_L_TABLE 64
+
+// OCB3 (RFC 7253) з тегом 128 бітів. Зсуви Offset_i = Offset_{i-1} ^ L_ntz(i)
+// для пакета обчислюються з наперед підготовленої таблиці L, після чого
+// весь пакет шифрується одним викликом багатоблокового ядра.
+// nonce від 1 до 15 байтів; out може збігатися з in
+class CamelliaOCB {
+public:
+    explicit CamelliaOCB(const CamelliaKey& key);
+    bool Encrypt(const unsigned char* nonce, size_t nonceLength, const unsigned char* aad, size_t aadLength,
+        const unsigned char* in, size_t length, unsigned char* out, unsigned char* tag) const;
+    // false, якщо тег не збігся; тоді out заповнюється нулями
+    bool Decrypt(const unsigned char* nonce, size_t nonceLength, const unsigned char* aad, size_t aadLength,
+        const unsigned char* in, size_t length, const unsigned char* tag, unsigned char* out) const;
+private:
+    void Hash(const unsigned char* aad, size_t length, unsigned char* sum) const;
+    void InitialOffset(const unsigned char* nonce, size_t nonceLength, unsigned char* offset) const;
+    void Crypt(const unsigned char* nonce, size_t nonceLength, const unsigned char* aad, size_t aadLength,
+        const unsigned char* in, size_t length, unsigned char* out, unsigned char* tag, bool decrypt) const;
+
+    CamelliaKey key;
+    unsigned char lStar[BLOCK_128_BIT], lDollar[BLOCK_128_BIT];
+    unsigned char l[CAMELLIA_OCB_L_TABLE][BLOCK_128_BIT];
+};
+
+// Скільки блоків XTS іде одним викликом ядра; стільки ж секторних твіків шифрується разом
+#define CAMELLIA_XTS_BLOCKS 32
+// Множення твіка на x через SSE2 (зсув 64-бітних половин і перенесення в регістрі);
+// інакше побайтово
+#define CAMELLIA_XTS_SSE2 1
+
+// XTS (IEEE 1619) для дискових одиниць даних: length байтів - це length / unitSize
+// послідовних одиниць з номерами sector, sector + 1, ...; твік одиниці -
+// E(tweakKey, номер як 64-бітне little-endian число, старші 8 байтів нульові).
+// Твіки всередині одиниці множаться на x пакетами, і пакет шифрується одним
+// викликом багатоблокового ядра. unitSize не кратний 16 обробляється
+// викраденням шифротексту. out може збігатися з in
+class CamelliaXTS {
+public:
+    CamelliaXTS(const CamelliaKey& dataKey, const CamelliaKey& tweakKey);
+    // false, якщо unitSize < 16 або length не кратна unitSize
+    bool Encrypt(u64 sector, const unsigned char* in, unsigned char* out, size_t length, size_t unitSize) const;
+    bool Decrypt(u64 sector, const unsigned char* in, unsigned char* out, size_t length, size_t unitSize) const;
+    // Те саме на threads потоках (0 або більше, ніж ядер, - за кількістю ядер):
+    // одиниці діляться на суцільні діапазони секторів, один з яких обробляє потік
+    // викликача. Кожен потік отримує щонайменше CAMELLIA_XTS_BLOCKS блоків (і хоча б
+    // одну одиницю), тож малі запити йдуть одним потоком
+    bool Encrypt(u64 sector, const unsigned char* in, unsigned char* out, size_t length, size_t unitSize,
+        unsigned threads) const;
+    bool Decrypt(u64 sector, const unsigned char* in, unsigned char* out, size_t length, size_t unitSize,
+        unsigned threads) const;
+private:
+    bool CryptParallel(u64 sector, const unsigned char* in, unsigned char* out, size_t length, size_t unitSize,
+        bool decrypt, unsigned threads) const;
+    bool Crypt(u64 sector, const unsigned char* in, unsigned char* out, size_t length, size_t unitSize,
+        bool decrypt) const;
+    void CryptUnit(unsigned char* tweak, const unsigned char* in, unsigned char* out, size_t unitSize,
+        bool decrypt) const;
+    void CryptBlock(const unsigned char* tweak, const unsigned char* in, unsigned char* out, bool decrypt) const;
+
+    CamelliaKey dataKey, tweakKey;
+};
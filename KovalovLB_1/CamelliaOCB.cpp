@@ -0,0 +1,168 @@
+#include "CamelliaModes.h"
+
+// double(S) у GF(2^128): зсув вліво на 1 і x^7 + x^2 + x + 1 при перенесенні
+static void Double(const unsigned char* in, unsigned char* out) {
+    unsigned char carry = in[0] >> 7;
+    for (int i = 0; i < BLOCK_128_BIT - 1; i++)
+        out[i] = (unsigned char)((in[i] << 1) | (in[i + 1] >> 7));
+    out[BLOCK_128_BIT - 1] = (unsigned char)((in[BLOCK_128_BIT - 1] << 1) ^ (0x87 & (0 - carry)));
+}
+
+static inline int Ntz(u64 i) {
+    int n = 0;
+    while (!(i & 1)) {
+        i >>= 1;
+        n++;
+    }
+    return n;
+}
+
+CamelliaOCB::CamelliaOCB(const CamelliaKey& key) : key(key)
+{
+    const Camellia cipher;
+    memset(lStar, 0, sizeof(lStar));
+    cipher.EncryptBlocks(key, lStar, lStar, 1);
+    Double(lStar, lDollar);
+    Double(lDollar, l[0]);
+    for (int i = 1; i < CAMELLIA_OCB_L_TABLE; i++)
+        Double(l[i - 1], l[i]);
+}
+
+// HASH(K, A): ті самі зсуви, що й для тексту, але від нульового Offset
+void CamelliaOCB::Hash(const unsigned char* aad, size_t length, unsigned char* sum) const {
+    const Camellia cipher;
+    unsigned char offset[BLOCK_128_BIT] = {};
+    unsigned char buffer[CAMELLIA_OCB_BLOCKS * BLOCK_128_BIT];
+    memset(sum, 0, BLOCK_128_BIT);
+    size_t blocks = length / BLOCK_128_BIT;
+    u64 index = 0;
+
+    while (blocks) {
+        size_t n = blocks < CAMELLIA_OCB_BLOCKS ? blocks : CAMELLIA_OCB_BLOCKS;
+        for (size_t b = 0; b < n; b++) {
+            CamelliaXor(offset, l[Ntz(++index)], offset, BLOCK_128_BIT);
+            CamelliaXor(aad + b * BLOCK_128_BIT, offset, buffer + b * BLOCK_128_BIT, BLOCK_128_BIT);
+        }
+        cipher.EncryptBlocks(key, buffer, buffer, n);
+        for (size_t b = 0; b < n; b++)
+            CamelliaXor(sum, buffer + b * BLOCK_128_BIT, sum, BLOCK_128_BIT);
+        aad += n * BLOCK_128_BIT;
+        blocks -= n;
+    }
+
+    size_t rest = length % BLOCK_128_BIT;
+    if (rest) {
+        unsigned char last[BLOCK_128_BIT] = {};
+        memcpy(last, aad, rest);
+        last[rest] = 0x80;
+        CamelliaXor(offset, lStar, offset, BLOCK_128_BIT);
+        CamelliaXor(last, offset, last, BLOCK_128_BIT);
+        cipher.EncryptBlocks(key, last, last, 1);
+        CamelliaXor(sum, last, sum, BLOCK_128_BIT);
+    }
+}
+
+// Offset_0 = Stretch[1 + bottom .. 128 + bottom], де Stretch = Ktop || (Ktop[1..64] ^ Ktop[9..72])
+void CamelliaOCB::InitialOffset(const unsigned char* nonce, size_t nonceLength, unsigned char* offset) const {
+    unsigned char block[BLOCK_128_BIT] = {};
+    block[0] = (unsigned char)((CAMELLIA_OCB_TAG * 8 % 128) << 1);
+    block[BLOCK_128_BIT - 1 - nonceLength] |= 1;
+    memcpy(block + BLOCK_128_BIT - nonceLength, nonce, nonceLength);
+    int bottom = block[BLOCK_128_BIT - 1] & 0x3f;
+    block[BLOCK_128_BIT - 1] &= 0xc0;
+
+    unsigned char stretch[BLOCK_128_BIT + 8];
+    const Camellia cipher;
+    cipher.EncryptBlocks(key, block, stretch, 1);
+    for (int i = 0; i < 8; i++)
+        stretch[BLOCK_128_BIT + i] = stretch[i] ^ stretch[i + 1];
+
+    int bytes = bottom / 8, bits = bottom % 8;
+    for (int i = 0; i < BLOCK_128_BIT; i++)
+        offset[i] = (unsigned char)((stretch[i + bytes] << bits) | (stretch[i + bytes + 1] >> (8 - bits)));
+}
+
+void CamelliaOCB::Crypt(const unsigned char* nonce, size_t nonceLength, const unsigned char* aad, size_t aadLength,
+    const unsigned char* in, size_t length, unsigned char* out, unsigned char* tag, bool decrypt) const
+{
+    const Camellia cipher;
+    unsigned char offset[BLOCK_128_BIT], checksum[BLOCK_128_BIT] = {};
+    unsigned char offsets[CAMELLIA_OCB_BLOCKS * BLOCK_128_BIT];
+    unsigned char buffer[CAMELLIA_OCB_BLOCKS * BLOCK_128_BIT];
+    InitialOffset(nonce, nonceLength, offset);
+    size_t blocks = length / BLOCK_128_BIT;
+    u64 index = 0;
+
+    while (blocks) {
+        size_t n = blocks < CAMELLIA_OCB_BLOCKS ? blocks : CAMELLIA_OCB_BLOCKS;
+        size_t bytes = n * BLOCK_128_BIT;
+        for (size_t b = 0; b < n; b++) {
+            CamelliaXor(offset, l[Ntz(++index)], offset, BLOCK_128_BIT);
+            memcpy(offsets + b * BLOCK_128_BIT, offset, BLOCK_128_BIT);
+        }
+        // Контрольна сума рахується з відкритого тексту: при шифруванні - до того,
+        // як out перезапише in, при розшифруванні - з готового out
+        if (!decrypt)
+            for (size_t b = 0; b < n; b++)
+                CamelliaXor(checksum, in + b * BLOCK_128_BIT, checksum, BLOCK_128_BIT);
+        CamelliaXor(in, offsets, buffer, bytes);
+        if (decrypt)
+            cipher.DecryptBlocks(key, buffer, buffer, n);
+        else
+            cipher.EncryptBlocks(key, buffer, buffer, n);
+        CamelliaXor(buffer, offsets, out, bytes);
+        if (decrypt)
+            for (size_t b = 0; b < n; b++)
+                CamelliaXor(checksum, out + b * BLOCK_128_BIT, checksum, BLOCK_128_BIT);
+        in += bytes;
+        out += bytes;
+        blocks -= n;
+    }
+
+    size_t rest = length % BLOCK_128_BIT;
+    if (rest) {
+        unsigned char pad[BLOCK_128_BIT], last[BLOCK_128_BIT] = {};
+        CamelliaXor(offset, lStar, offset, BLOCK_128_BIT);
+        cipher.EncryptBlocks(key, offset, pad, 1);
+        memcpy(last, in, rest);
+        CamelliaXor(last, pad, out, rest);
+        if (decrypt)
+            memcpy(last, out, rest);
+        last[rest] = 0x80;
+        CamelliaXor(checksum, last, checksum, BLOCK_128_BIT);
+    }
+
+    // Tag = E(Checksum ^ Offset ^ L_$) ^ HASH(K, A)
+    CamelliaXor(checksum, offset, checksum, BLOCK_128_BIT);
+    CamelliaXor(checksum, lDollar, checksum, BLOCK_128_BIT);
+    cipher.EncryptBlocks(key, checksum, checksum, 1);
+    unsigned char sum[BLOCK_128_BIT];
+    Hash(aad, aadLength, sum);
+    CamelliaXor(checksum, sum, tag, BLOCK_128_BIT);
+}
+
+bool CamelliaOCB::Encrypt(const unsigned char* nonce, size_t nonceLength, const unsigned char* aad, size_t aadLength,
+    const unsigned char* in, size_t length, unsigned char* out, unsigned char* tag) const
+{
+    if (nonceLength == 0 || nonceLength >= BLOCK_128_BIT)
+        return false;
+    Crypt(nonce, nonceLength, aad, aadLength, in, length, out, tag, false);
+    return true;
+}
+
+bool CamelliaOCB::Decrypt(const unsigned char* nonce, size_t nonceLength, const unsigned char* aad, size_t aadLength,
+    const unsigned char* in, size_t length, const unsigned char* tag, unsigned char* out) const
+{
+    if (nonceLength == 0 || nonceLength >= BLOCK_128_BIT)
+        return false;
+    unsigned char expected[CAMELLIA_OCB_TAG];
+    Crypt(nonce, nonceLength, aad, aadLength, in, length, out, expected, true);
+    unsigned char diff = 0;
+    for (int i = 0; i < CAMELLIA_OCB_TAG; i++)
+        diff |= expected[i] ^ tag[i];
+    if (diff) {
+        memset(out, 0, length);
+        return false;
+    }
+    return true;
+}
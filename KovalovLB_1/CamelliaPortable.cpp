@@ -0,0 +1,69 @@
+#include "CamelliaSimd.h"
+#include "CamelliaSBOX.h"
+
+// Переносний бекенд: кожна лінійка вектора - окремий блок, 64-бітні половини
+// L та R зберігаються двома 32-бітними словами, а S-блоки з P-функцією
+// беруться із SP-таблиць CamelliaSBOX.h через gather
+typedef Simd<u32, CAMELLIA_PORTABLE_BLOCKS> Lanes;
+
+static inline u32 LoadBE32(const unsigned char* p) {
+    return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | p[3];
+}
+static inline void StoreBE32(unsigned char* p, u32 x) {
+    p[0] = (unsigned char)(x >> 24);
+    p[1] = (unsigned char)(x >> 16);
+    p[2] = (unsigned char)(x >> 8);
+    p[3] = (unsigned char)x;
+}
+
+// Права половина F_Func накладається на (y0, y1)
+static inline void RoundF(const Lanes& x0, const Lanes& x1, Lanes& y0, Lanes& y1, u64 key) {
+    Lanes a = x0 ^ Lanes::Broadcast((u32)(key >> 32));
+    Lanes b = x1 ^ Lanes::Broadcast((u32)key);
+    const CamelliaTables& t = CAMELLIA_TABLES;
+    a = Gather(t.sp1110, a >> 24) ^ Gather(t.sp0222, a >> 16) ^ Gather(t.sp3033, a >> 8) ^ Gather(t.sp4404, a);
+    b = Gather(t.sp0222, b >> 24) ^ Gather(t.sp3033, b >> 16) ^ Gather(t.sp4404, b >> 8) ^ Gather(t.sp1110, b);
+    Lanes left = a ^ b;
+    y0 = y0 ^ left;
+    y1 = y1 ^ left ^ Rotl(a, 24);
+}
+
+static inline void FL(Lanes& x1, Lanes& x2, u64 key) {
+    x2 = x2 ^ Rotl(x1 & Lanes::Broadcast((u32)(key >> 32)), 1);
+    x1 = x1 ^ (x2 | Lanes::Broadcast((u32)key));
+}
+
+static inline void FLINV(Lanes& y1, Lanes& y2, u64 key) {
+    y1 = y1 ^ (y2 | Lanes::Broadcast((u32)key));
+    y2 = y2 ^ Rotl(y1 & Lanes::Broadcast((u32)(key >> 32)), 1);
+}
+
+void CamelliaPortable_Crypt(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out)
+{
+    Lanes x[4];
+    for (int i = 0; i < CAMELLIA_PORTABLE_BLOCKS; i++)
+        for (int w = 0; w < 4; w++)
+            x[w].lane[i] = LoadBE32(in + i * BLOCK_128_BIT + 4 * w);
+
+    x[0] = x[0] ^ Lanes::Broadcast((u32)(kw[0] >> 32)); // Попереднє забілювання
+    x[1] = x[1] ^ Lanes::Broadcast((u32)kw[0]);
+    x[2] = x[2] ^ Lanes::Broadcast((u32)(kw[1] >> 32));
+    x[3] = x[3] ^ Lanes::Broadcast((u32)kw[1]);
+    for (int i = 0; i < rounds; i += 2) {
+        if (i > 0 && i % 6 == 0) {
+            FL(x[0], x[1], ke[i / 3 - 2]);
+            FLINV(x[2], x[3], ke[i / 3 - 1]);
+        }
+        RoundF(x[0], x[1], x[2], x[3], k[i]);
+        RoundF(x[2], x[3], x[0], x[1], k[i + 1]);
+    }
+    x[2] = x[2] ^ Lanes::Broadcast((u32)(kw[2] >> 32)); // Фінальне забілювання
+    x[3] = x[3] ^ Lanes::Broadcast((u32)kw[2]);
+    x[0] = x[0] ^ Lanes::Broadcast((u32)(kw[3] >> 32));
+    x[1] = x[1] ^ Lanes::Broadcast((u32)kw[3]);
+
+    for (int i = 0; i < CAMELLIA_PORTABLE_BLOCKS; i++)
+        for (int w = 0; w < 4; w++)
+            StoreBE32(out + i * BLOCK_128_BIT + 4 * w, x[(w + 2) & 3].lane[i]);
+}
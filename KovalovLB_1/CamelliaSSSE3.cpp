@@ -0,0 +1,84 @@
+#include "CamelliaByteslice.h"
+
+// S-блоки без AES-NI: s(x) = post(inv(pre(x))), де інверсія в GF(2^8)
+// рахується в баштовому полі GF((2^4)^2), Y^2 = Y + 8, над GF(16) = GF(2)[x]/(x^4 + x + 1).
+// Байт h:l після pre задає елемент hY + l, обернений до нього -
+//   (h / d)Y + (h + l) / d, d = 8h^2 + hl + l^2,
+// а множення та ділення в GF(16) виконуються через PSHUFB-таблиці логарифмів.
+alignas(16) static const unsigned char PRE_S1_LO[16] = {
+    0x4c, 0x4d, 0x3d, 0x3c, 0x41, 0x40, 0x30, 0x31, 0x11, 0x10, 0x60, 0x61, 0x1c, 0x1d, 0x6d, 0x6c };
+alignas(16) static const unsigned char PRE_S1_HI[16] = {
+    0x00, 0x57, 0xf8, 0xaf, 0xe0, 0xb7, 0x18, 0x4f, 0xa0, 0xf7, 0x58, 0x0f, 0x40, 0x17, 0xb8, 0xef };
+alignas(16) static const unsigned char PRE_S4_LO[16] = {
+    0x4c, 0x3d, 0x41, 0x30, 0x11, 0x60, 0x1c, 0x6d, 0x1b, 0x6a, 0x16, 0x67, 0x46, 0x37, 0x4b, 0x3a };
+alignas(16) static const unsigned char PRE_S4_HI[16] = {
+    0x00, 0xf8, 0xe0, 0x18, 0xa0, 0x58, 0x40, 0xb8, 0x01, 0xf9, 0xe1, 0x19, 0xa1, 0x59, 0x41, 0xb9 };
+alignas(16) static const unsigned char POST_S1_LO[16] = {
+    0x6e, 0x9f, 0x32, 0xc3, 0x79, 0x88, 0x25, 0xd4, 0xb5, 0x44, 0xe9, 0x18, 0xa2, 0x53, 0xfe, 0x0f };
+alignas(16) static const unsigned char POST_S1_HI[16] = {
+    0x00, 0x8d, 0xbb, 0x36, 0xc5, 0x48, 0x7e, 0xf3, 0x79, 0xf4, 0xc2, 0x4f, 0xbc, 0x31, 0x07, 0x8a };
+alignas(16) static const unsigned char POST_S2_LO[16] = {
+    0xdc, 0x3f, 0x64, 0x87, 0xf2, 0x11, 0x4a, 0xa9, 0x6b, 0x88, 0xd3, 0x30, 0x45, 0xa6, 0xfd, 0x1e };
+alignas(16) static const unsigned char POST_S2_HI[16] = {
+    0x00, 0x1b, 0x77, 0x6c, 0x8b, 0x90, 0xfc, 0xe7, 0xf2, 0xe9, 0x85, 0x9e, 0x79, 0x62, 0x0e, 0x15 };
+alignas(16) static const unsigned char POST_S3_LO[16] = {
+    0x37, 0xcf, 0x19, 0xe1, 0xbc, 0x44, 0x92, 0x6a, 0xda, 0x22, 0xf4, 0x0c, 0x51, 0xa9, 0x7f, 0x87 };
+alignas(16) static const unsigned char POST_S3_HI[16] = {
+    0x00, 0xc6, 0xdd, 0x1b, 0xe2, 0x24, 0x3f, 0xf9, 0xbc, 0x7a, 0x61, 0xa7, 0x5e, 0x98, 0x83, 0x45 };
+// log(0) = 0xf0: сума з насиченням лишає старший біт, і PSHUFB по EXP дає 0
+alignas(16) static const unsigned char GF16_LOG[16] = {
+    0xf0, 0, 1, 4, 2, 8, 5, 10, 3, 14, 9, 7, 6, 13, 11, 12 };
+alignas(16) static const unsigned char GF16_NEG_LOG[16] = {
+    0xf0, 0, 14, 11, 13, 7, 10, 5, 12, 1, 6, 8, 9, 2, 4, 3 };
+alignas(16) static const unsigned char GF16_EXP[16] = {
+    1, 2, 4, 8, 3, 6, 12, 11, 5, 10, 7, 14, 15, 13, 9, 0 };
+// 8h^2 та l^2 для знаменника d
+alignas(16) static const unsigned char GF16_LAMBDA_SQ[16] = {
+    0, 8, 6, 14, 11, 3, 13, 5, 10, 2, 12, 4, 1, 9, 7, 15 };
+alignas(16) static const unsigned char GF16_SQ[16] = {
+    0, 1, 4, 5, 3, 2, 7, 6, 12, 13, 8, 9, 15, 14, 11, 10 };
+
+struct SSSE3SBoxes {
+    __m128i preS1Lo, preS1Hi, preS4Lo, preS4Hi;
+    __m128i postS1Lo, postS1Hi, postS2Lo, postS2Hi, postS3Lo, postS3Hi;
+    __m128i log, negLog, exp, lambdaSq, sq, lowNibble, fifteen;
+
+    SSSE3SBoxes() :
+        preS1Lo(VTable<__m128i>(PRE_S1_LO)), preS1Hi(VTable<__m128i>(PRE_S1_HI)),
+        preS4Lo(VTable<__m128i>(PRE_S4_LO)), preS4Hi(VTable<__m128i>(PRE_S4_HI)),
+        postS1Lo(VTable<__m128i>(POST_S1_LO)), postS1Hi(VTable<__m128i>(POST_S1_HI)),
+        postS2Lo(VTable<__m128i>(POST_S2_LO)), postS2Hi(VTable<__m128i>(POST_S2_HI)),
+        postS3Lo(VTable<__m128i>(POST_S3_LO)), postS3Hi(VTable<__m128i>(POST_S3_HI)),
+        log(VTable<__m128i>(GF16_LOG)), negLog(VTable<__m128i>(GF16_NEG_LOG)), exp(VTable<__m128i>(GF16_EXP)),
+        lambdaSq(VTable<__m128i>(GF16_LAMBDA_SQ)), sq(VTable<__m128i>(GF16_SQ)),
+        lowNibble(VSet1<__m128i>(0x0f)), fifteen(VSet1<__m128i>(15)) {}
+
+    // Добуток за логарифмами: (a + b) mod 15, нульовий множник дає 0
+    __m128i Mul(__m128i logA, __m128i logB) const {
+        __m128i s = _mm_adds_epu8(logA, logB);
+        return VShuffle(exp, _mm_min_epu8(s, _mm_sub_epi8(s, fifteen)));
+    }
+
+    __m128i SubBytes(__m128i x, __m128i preLo, __m128i preHi, __m128i postLo, __m128i postHi) const {
+        x = Filter(x, preLo, preHi, lowNibble);
+        __m128i l = VAnd(x, lowNibble);
+        __m128i h = VAnd(VSrl16(x, 4), lowNibble);
+        __m128i logH = VShuffle(log, h);
+
+        __m128i d = VXor(VXor(VShuffle(lambdaSq, h), VShuffle(sq, l)), Mul(logH, VShuffle(log, l)));
+        __m128i logInvD = VShuffle(negLog, d);
+        __m128i invH = Mul(logH, logInvD);
+        __m128i invL = Mul(VShuffle(log, VXor(h, l)), logInvD);
+        return VXor(VShuffle(postLo, invL), VShuffle(postHi, invH));
+    }
+    __m128i S1(__m128i x) const { return SubBytes(x, preS1Lo, preS1Hi, postS1Lo, postS1Hi); }
+    __m128i S2(__m128i x) const { return SubBytes(x, preS1Lo, preS1Hi, postS2Lo, postS2Hi); }
+    __m128i S3(__m128i x) const { return SubBytes(x, preS1Lo, preS1Hi, postS3Lo, postS3Hi); }
+    __m128i S4(__m128i x) const { return SubBytes(x, preS4Lo, preS4Hi, postS1Lo, postS1Hi); }
+};
+
+void CamelliaSSSE3_Crypt16(const u64* kw, const u64* ke, const u64* k, int rounds,
+    const unsigned char* in, unsigned char* out)
+{
+    CamelliaByteSliced<__m128i, SSSE3SBoxes>(kw, ke, k, rounds, in, out);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "Camellia.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Вектор з N однотипних лінійок. Операції записані циклами по лінійках,
+// тож компілятор сам векторизує їх під цільовий набір інструкцій
+// (SSE2, AVX2, ...); ширина змінюється лише параметром N
+template <typename T, int N>
+struct Simd {
+    alignas(sizeof(T) * N < 64 ? sizeof(T) * N : 64) T lane[N];
+
+    static Simd Broadcast(T x) {
+        Simd r;
+        for (int i = 0; i < N; i++)
+            r.lane[i] = x;
+        return r;
+    }
+};
+
+template <typename T, int N>
+inline Simd<T, N> operator^(const Simd<T, N>& a, const Simd<T, N>& b) {
+    Simd<T, N> r;
+    for (int i = 0; i < N; i++)
+        r.lane[i] = a.lane[i] ^ b.lane[i];
+    return r;
+}
+template <typename T, int N>
+inline Simd<T, N> operator&(const Simd<T, N>& a, const Simd<T, N>& b) {
+    Simd<T, N> r;
+    for (int i = 0; i < N; i++)
+        r.lane[i] = a.lane[i] & b.lane[i];
+    return r;
+}
+template <typename T, int N>
+inline Simd<T, N> operator|(const Simd<T, N>& a, const Simd<T, N>& b) {
+    Simd<T, N> r;
+    for (int i = 0; i < N; i++)
+        r.lane[i] = a.lane[i] | b.lane[i];
+    return r;
+}
+template <typename T, int N>
+inline Simd<T, N> operator>>(const Simd<T, N>& a, int n) {
+    Simd<T, N> r;
+    for (int i = 0; i < N; i++)
+        r.lane[i] = a.lane[i] >> n;
+    return r;
+}
+template <typename T, int N>
+inline Simd<T, N> operator<<(const Simd<T, N>& a, int n) {
+    Simd<T, N> r;
+    for (int i = 0; i < N; i++)
+        r.lane[i] = a.lane[i] << n;
+    return r;
+}
+template <int N>
+inline Simd<u32, N> Rotl(const Simd<u32, N>& a, int n) {
+    return (a << n) | (a >> (32 - n));
+}
+
+// Табличне звернення для кожної лінійки: r[i] = table[index[i] & 0xff]
+template <int N>
+inline Simd<u32, N> Gather(const u32* table, const Simd<u32, N>& index) {
+    Simd<u32, N> r;
+    for (int i = 0; i < N; i++)
+        r.lane[i] = table[index.lane[i] & MASK8];
+    return r;
+}
+#if defined(__AVX2__)
+// Автовекторизатор не синтезує gather сам, тому для 8 лінійок - VPGATHERDD
+template <>
+inline Simd<u32, 8> Gather<8>(const u32* table, const Simd<u32, 8>& index) {
+    __m256i idx = _mm256_and_si256(_mm256_load_si256((const __m256i*)index.lane), _mm256_set1_epi32(MASK8));
+    Simd<u32, 8> r;
+    _mm256_store_si256((__m256i*)r.lane, _mm256_i32gather_epi32((const int*)table, idx, 4));
+    return r;
+}
+#endif
@@ -0,0 +1,187 @@
+#include "CamelliaModes.h"
+#include <system_error>
+#include <thread>
+#include <vector>
+#if CAMELLIA_XTS_SSE2
+#include <emmintrin.h>
+#endif
+
+// tweak = tweak * x у GF(2^128) з little-endian порядком байтів;
+// tweaks отримує count послідовних значень, починаючи з поточного
+static void NextTweaks(unsigned char* tweak, unsigned char* tweaks, size_t count) {
+#if CAMELLIA_XTS_SSE2
+    // Знакові біти 63 і 127 переносяться у біти 64 і 0 (з 0x87) однією перестановкою
+    const __m128i poly = _mm_set_epi32(0, 1, 0, 0x87);
+    __m128i t = _mm_loadu_si128((const __m128i*)tweak);
+    for (size_t i = 0; i < count; i++) {
+        _mm_storeu_si128((__m128i*)(tweaks + i * BLOCK_128_BIT), t);
+        __m128i carry = _mm_and_si128(_mm_shuffle_epi32(_mm_srai_epi32(t, 31), 0x13), poly);
+        t = _mm_xor_si128(_mm_add_epi64(t, t), carry);
+    }
+    _mm_storeu_si128((__m128i*)tweak, t);
+#else
+    for (size_t i = 0; i < count; i++) {
+        memcpy(tweaks + i * BLOCK_128_BIT, tweak, BLOCK_128_BIT);
+        unsigned char carry = tweak[BLOCK_128_BIT - 1] >> 7;
+        for (int j = BLOCK_128_BIT - 1; j > 0; j--)
+            tweak[j] = (unsigned char)((tweak[j] << 1) | (tweak[j - 1] >> 7));
+        tweak[0] = (unsigned char)((tweak[0] << 1) ^ (0x87 & (0 - carry)));
+    }
+#endif
+}
+
+CamelliaXTS::CamelliaXTS(const CamelliaKey& dataKey, const CamelliaKey& tweakKey)
+    : dataKey(dataKey), tweakKey(tweakKey)
+{
+}
+
+void CamelliaXTS::CryptBlock(const unsigned char* tweak, const unsigned char* in, unsigned char* out,
+    bool decrypt) const
+{
+    const Camellia cipher;
+    unsigned char block[BLOCK_128_BIT];
+    CamelliaXor(in, tweak, block, BLOCK_128_BIT);
+    if (decrypt)
+        cipher.DecryptBlocks(dataKey, block, block, 1);
+    else
+        cipher.EncryptBlocks(dataKey, block, block, 1);
+    CamelliaXor(block, tweak, out, BLOCK_128_BIT);
+}
+
+void CamelliaXTS::CryptUnit(unsigned char* tweak, const unsigned char* in, unsigned char* out, size_t unitSize,
+    bool decrypt) const
+{
+    const Camellia cipher;
+    unsigned char tweaks[CAMELLIA_XTS_BLOCKS * BLOCK_128_BIT];
+    unsigned char buffer[CAMELLIA_XTS_BLOCKS * BLOCK_128_BIT];
+    size_t rest = unitSize % BLOCK_128_BIT;
+    // Останній повний блок при викраденні шифротексту обробляється окремо
+    size_t blocks = unitSize / BLOCK_128_BIT - (rest ? 1 : 0);
+
+    while (blocks) {
+        size_t n = blocks < CAMELLIA_XTS_BLOCKS ? blocks : CAMELLIA_XTS_BLOCKS;
+        size_t bytes = n * BLOCK_128_BIT;
+        NextTweaks(tweak, tweaks, n);
+        CamelliaXor(in, tweaks, buffer, bytes);
+        if (decrypt)
+            cipher.DecryptBlocks(dataKey, buffer, buffer, n);
+        else
+            cipher.EncryptBlocks(dataKey, buffer, buffer, n);
+        CamelliaXor(buffer, tweaks, out, bytes);
+        in += bytes;
+        out += bytes;
+        blocks -= n;
+    }
+    if (!rest)
+        return;
+
+    // Викрадення шифротексту: T_{m-1} і T_m для останнього повного та неповного блоків.
+    // При розшифруванні повний блок знімається твіком T_m, а неповний - T_{m-1}
+    unsigned char last[2 * BLOCK_128_BIT], full[BLOCK_128_BIT], partial[BLOCK_128_BIT];
+    NextTweaks(tweak, last, 2);
+    const unsigned char* first = decrypt ? last + BLOCK_128_BIT : last;
+    const unsigned char* second = decrypt ? last : last + BLOCK_128_BIT;
+    CryptBlock(first, in, full, decrypt);
+    memcpy(partial, in + BLOCK_128_BIT, rest);
+    memcpy(partial + rest, full + rest, BLOCK_128_BIT - rest);
+    memcpy(out + BLOCK_128_BIT, full, rest);
+    CryptBlock(second, partial, out, decrypt);
+}
+
+bool CamelliaXTS::Crypt(u64 sector, const unsigned char* in, unsigned char* out, size_t length, size_t unitSize,
+    bool decrypt) const
+{
+    if (unitSize < BLOCK_128_BIT || length % unitSize)
+        return false;
+    const Camellia cipher;
+    unsigned char tweaks[CAMELLIA_XTS_BLOCKS * BLOCK_128_BIT];
+    size_t units = length / unitSize;
+
+    // Твіки кількох секторів шифруються одним викликом ядра
+    while (units) {
+        size_t n = units < CAMELLIA_XTS_BLOCKS ? units : CAMELLIA_XTS_BLOCKS;
+        memset(tweaks, 0, n * BLOCK_128_BIT);
+        for (size_t u = 0; u < n; u++, sector++)
+            for (int i = 0; i < 8; i++)
+                tweaks[u * BLOCK_128_BIT + i] = (unsigned char)(sector >> (8 * i));
+        cipher.EncryptBlocks(tweakKey, tweaks, tweaks, n);
+        for (size_t u = 0; u < n; u++) {
+            CryptUnit(tweaks + u * BLOCK_128_BIT, in, out, unitSize, decrypt);
+            in += unitSize;
+            out += unitSize;
+        }
+        units -= n;
+    }
+    return true;
+}
+
+bool CamelliaXTS::Encrypt(u64 sector, const unsigned char* in, unsigned char* out, size_t length,
+    size_t unitSize) const
+{
+    return Crypt(sector, in, out, length, unitSize, false);
+}
+
+bool CamelliaXTS::Decrypt(u64 sector, const unsigned char* in, unsigned char* out, size_t length,
+    size_t unitSize) const
+{
+    return Crypt(sector, in, out, length, unitSize, true);
+}
+
+// Кожен потік отримує суцільний діапазон одиниць, тобто секторів; діапазони
+// не перетинаються, тож потоки не ділять ні вхідних, ні вихідних байтів
+bool CamelliaXTS::CryptParallel(u64 sector, const unsigned char* in, unsigned char* out, size_t length,
+    size_t unitSize, bool decrypt, unsigned threads) const
+{
+    if (unitSize < BLOCK_128_BIT || length % unitSize)
+        return false;
+    size_t units = length / unitSize;
+    // Більше потоків, ніж ядер, лише витрачає час на перемикання
+    unsigned cores = std::thread::hardware_concurrency();
+    if (threads == 0 || (cores && threads > cores))
+        threads = cores;
+    // Потік, що отримав менше за пакет блоків, не окупає свого створення;
+    // рахуються блоки, а не одиниці, тож великі сектори теж діляться
+    size_t most = length / BLOCK_128_BIT / CAMELLIA_XTS_BLOCKS;
+    if (most > units)
+        most = units;
+    if (threads > most)
+        threads = most ? (unsigned)most : 1;
+    if (threads <= 1)
+        return Crypt(sector, in, out, length, unitSize, decrypt);
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    size_t share = units / threads, extra = units % threads;
+    size_t first = share + (extra != 0);
+    size_t start = first;
+    for (unsigned t = 1; t < threads; t++) {
+        size_t count = share + (t < extra);
+        const unsigned char* from = in + start * unitSize;
+        unsigned char* to = out + start * unitSize;
+        try {
+            workers.emplace_back(&CamelliaXTS::Crypt, this, sector + start, from, to, count * unitSize,
+                unitSize, decrypt);
+        }
+        catch (const std::system_error&) {
+            // Потік не створився: його діапазон обробляє викликач
+            Crypt(sector + start, from, to, count * unitSize, unitSize, decrypt);
+        }
+        start += count;
+    }
+    Crypt(sector, in, out, first * unitSize, unitSize, decrypt);
+    for (std::thread& worker : workers)
+        worker.join();
+    return true;
+}
+
+bool CamelliaXTS::Encrypt(u64 sector, const unsigned char* in, unsigned char* out, size_t length,
+    size_t unitSize, unsigned threads) const
+{
+    return CryptParallel(sector, in, out, length, unitSize, false, threads);
+}
+
+bool CamelliaXTS::Decrypt(u64 sector, const unsigned char* in, unsigned char* out, size_t length,
+    size_t unitSize, unsigned threads) const
+{
+    return CryptParallel(sector, in, out, length, unitSize, true, threads);
+}